@@ -0,0 +1,28 @@
+/**
+ * @file bench.h
+ * @brief Timing helpers shared by the benchmark drivers (`make bench`).
+ */
+
+#ifndef COLOR_BENCH_H
+#define COLOR_BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/* Keeps results alive so the measured work is not optimized out */
+static volatile uint64_t g_bench_sink;
+
+static double bench_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* One result line: name, rate in 'unit' per second, and the time per operation */
+static void bench_report(const char *name, double ops, double seconds, const char *unit) {
+    printf("  %-36s %12.1f %s/s  %9.2f ns/op\n", name, ops / seconds, unit, seconds * 1e9 / ops);
+}
+
+#endif /* COLOR_BENCH_H */
@@ -0,0 +1,52 @@
+/* frame_write() of a 200x600 heatmap to /dev/null with 1 to 8 threads; more threads than CPUs only measure the overhead */
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_frame.h"
+#include "bench.h"
+
+#define BENCH_ROWS 200
+#define BENCH_COLS 600
+#define BENCH_FRAMES 200
+
+
+int main(void) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    t_frame_cell *cells = malloc((size_t)BENCH_ROWS * BENCH_COLS * sizeof(t_frame_cell));
+    t_cursor_pos origin = {1, 1};
+    char name[64];
+
+    if (null_fd < 0 || !cells) return 1;
+
+    /* Pen changes on every cell, the worst case for the encoder */
+    for (int y = 0; y < BENCH_ROWS; y++) {
+        for (int x = 0; x < BENCH_COLS; x++) {
+            t_frame_cell *c = &cells[y * BENCH_COLS + x];
+            c->ch = (x % 3) ? 0x2580 : ' ';
+            c->fg = (t_rgb){(uint8_t)x, (uint8_t)y, (uint8_t)(x ^ y)};
+            c->bg = (t_rgb){(uint8_t)(y * 3), (uint8_t)(x * 7), 64};
+        }
+    }
+
+    printf("\nframe (%dx%d cells to /dev/null, %ld online CPUs)\n", BENCH_ROWS, BENCH_COLS, sysconf(_SC_NPROCESSORS_ONLN));
+    for (unsigned threads = 1; threads <= 8; threads++) {
+        t_frame_pool *pool = frame_pool_new(threads);
+        if (!pool) return 1;
+
+        ssize_t bytes = 0;
+        double t = bench_now();
+        for (int i = 0; i < BENCH_FRAMES; i++) bytes = frame_write(pool, null_fd, cells, BENCH_ROWS, BENCH_COLS, origin);
+        t = bench_now() - t;
+
+        snprintf(name, sizeof(name), "%u thread%s (%zd bytes/frame)", threads, (threads > 1) ? "s" : "", bytes);
+        bench_report(name, BENCH_FRAMES, t, "frame");
+        frame_pool_free(pool);
+    }
+
+    free(cells);
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,60 @@
+/* html_convert() throughput on plain text, colored log lines and dense 256/RGB color changes */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_html.h"
+#include "bench.h"
+
+#define BENCH_INPUT (1 << 20)
+#define BENCH_ROUNDS 20
+
+
+/* Repeats 'pattern' into a BENCH_INPUT buffer */
+static char *make_input(const char *pattern) {
+    char *buf = malloc(BENCH_INPUT);
+    size_t len = strlen(pattern);
+
+    if (!buf) return NULL;
+    for (size_t i = 0; i < BENCH_INPUT; i++) buf[i] = pattern[i % len];
+    return buf;
+}
+
+
+static void bench_convert(const char *name, const char *pattern, HtmlStyleMode mode) {
+    static char out[4 * 16384];
+    char *in = make_input(pattern);
+    t_html_conv conv;
+
+    if (!in) return;
+
+    double t = bench_now();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        size_t off = 0;
+        html_init(&conv, mode);
+        while (off < BENCH_INPUT) {
+            size_t used;
+            g_bench_sink += html_convert(&conv, in + off, BENCH_INPUT - off, &used, out, sizeof(out));
+            off += used;
+        }
+        g_bench_sink += html_finish(&conv, out, sizeof(out));
+    }
+    bench_report(name, (double)BENCH_INPUT * BENCH_ROUNDS, bench_now() - t, "byte");
+    free(in);
+}
+
+
+int main(void) {
+    const char *plain = "The quick brown fox jumps over the lazy dog, 0123456789.\n";
+    const char *log = "2026-10-18 14:03:27.042 \033[32m[INFO] \033[0m request served in 12 us <ok>\n";
+    const char *dense = "\033[38;5;196mA\033[48;2;10;20;30mB\033[1;4mC\033[0m ";
+
+    printf("\nhtml (%d MB per case)\n", BENCH_INPUT * BENCH_ROUNDS >> 20);
+    bench_convert("plain text", plain, HTML_STYLE_CLASSES);
+    bench_convert("log lines, classes", log, HTML_STYLE_CLASSES);
+    bench_convert("log lines, inline", log, HTML_STYLE_INLINE);
+    bench_convert("dense colors, classes", dense, HTML_STYLE_CLASSES);
+    bench_convert("dense colors, inline", dense, HTML_STYLE_INLINE);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * Logger throughput against stdio: the same formatted line written to /dev/null
+ * with LOG_INFO (one write() per line), printf and fprintf.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_log.h"
+#include "bench.h"
+
+#define BENCH_LINES 500000
+
+
+static void bench_logger(const char *name, LogTimeFormat time, unsigned char color) {
+    double t;
+
+    log_set_time_format(time);
+    log_set_color(color);
+
+    t = bench_now();
+    for (int i = 0; i < BENCH_LINES; i++) LOG_INFO("request %d served in %d us", i, i & 1023);
+    bench_report(name, BENCH_LINES, bench_now() - t, "line");
+}
+
+
+int main(void) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    FILE *null_file = fopen("/dev/null", "w");
+    double t;
+
+    if (null_fd < 0 || !null_file) return 1;
+
+    printf("\nlog (%d lines to /dev/null)\n", BENCH_LINES);
+    log_set_fd(null_fd);
+    bench_logger("LOG_INFO plain, no time", LOG_TIME_NONE, 0);
+    bench_logger("LOG_INFO colored, no time", LOG_TIME_NONE, 1);
+    bench_logger("LOG_INFO colored, millis", LOG_TIME_MILLIS, 1);
+
+    /* Fully buffered: fewer syscalls than the logger, no per-line guarantee */
+    t = bench_now();
+    for (int i = 0; i < BENCH_LINES; i++) fprintf(null_file, "[INFO]  request %d served in %d us\n", i, i & 1023);
+    fflush(null_file);
+    bench_report("fprintf (buffered)", BENCH_LINES, bench_now() - t, "line");
+
+    /* One write per line, like the logger */
+    t = bench_now();
+    for (int i = 0; i < BENCH_LINES; i++) {
+        fprintf(null_file, "[INFO]  request %d served in %d us\n", i, i & 1023);
+        fflush(null_file);
+    }
+    bench_report("fprintf + fflush", BENCH_LINES, bench_now() - t, "line");
+
+    /* printf with stdout redirected to /dev/null for the measurement */
+    int saved = dup(STDOUT_FILENO);
+    fflush(stdout);
+    dup2(null_fd, STDOUT_FILENO);
+    t = bench_now();
+    for (int i = 0; i < BENCH_LINES; i++) printf("[INFO]  request %d served in %d us\n", i, i & 1023);
+    fflush(stdout);
+    t = bench_now() - t;
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    bench_report("printf", BENCH_LINES, t, "line");
+
+    fclose(null_file);
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,36 @@
+/* color_parse() throughput per spec form: hex, rgb(), percentages and names */
+#define _POSIX_C_SOURCE 200809L
+#include "color_lib.h"
+#include "color_parse.h"
+#include "bench.h"
+
+#define BENCH_ROUNDS 2000000
+
+
+static void bench_specs(const char *name, const char *const *specs, int nb_specs) {
+    t_rgb rgb = {0, 0, 0};
+    double t = bench_now();
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        g_bench_sink += color_parse(specs[i % nb_specs], &rgb);
+        g_bench_sink += rgb.r;
+    }
+    bench_report(name, BENCH_ROUNDS, bench_now() - t, "spec");
+}
+
+
+int main(void) {
+    static const char *const hex[] = {"#FF8000", "#1e90ff", "#abc", "#000000"};
+    static const char *const func[] = {"rgb(255, 128, 0)", "rgb(30,144,255)", "rgba(1, 2, 3, 0.5)", "rgb(0 0 0)"};
+    static const char *const percent[] = {"rgb(100%, 50%, 0%)", "rgb(12.5%,25%,75.25%)", "rgb(0%,0%,0%)"};
+    static const char *const names[] = {"coral", "DarkSlateGray", "rebeccapurple", "white", "lightgoldenrodyellow"};
+    static const char *const unknown[] = {"not-a-color", "bluish", "#12345"};
+
+    printf("\nparse\n");
+    bench_specs("hex", hex, 4);
+    bench_specs("rgb()", func, 4);
+    bench_specs("rgb() percentages", percent, 3);
+    bench_specs("names", names, 5);
+    bench_specs("unknown", unknown, 3);
+    return 0;
+}
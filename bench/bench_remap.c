@@ -0,0 +1,113 @@
+/*
+ * remap_feed() throughput on sparse and dense SGR input, in 64 KB chunks, against a
+ * plain memcpy of the same data; remap_fd() from a temporary file to /dev/null.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_remap.h"
+#include "bench.h"
+
+#define BENCH_INPUT (32u << 20)
+#define BENCH_CHUNK 65536
+
+
+typedef struct s_bench_sink {
+    char *buf;
+    size_t len;
+} t_bench_sink;
+
+
+static int sink_writer(void *ctx, const char *data, size_t len) {
+    t_bench_sink *s = ctx;
+
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+    return 1;
+}
+
+
+static void bench_feed(const char *name, const t_remap_lut *lut, const char *in, char *out) {
+    t_bench_sink sink = {out, 0};
+    t_remap remap;
+    double t = bench_now();
+
+    remap_init(&remap, lut);
+    for (size_t off = 0; off < BENCH_INPUT; off += BENCH_CHUNK) {
+        size_t n = (BENCH_INPUT - off < BENCH_CHUNK) ? BENCH_INPUT - off : BENCH_CHUNK;
+        remap_feed(&remap, in + off, n, sink_writer, &sink);
+    }
+    remap_finish(&remap, sink_writer, &sink);
+    bench_report(name, BENCH_INPUT, bench_now() - t, "byte");
+    g_bench_sink += sink.len;
+}
+
+
+static void bench_fd(const char *name, const t_remap_lut *lut, const char *in) {
+    char path[] = "/tmp/bench_remap_XXXXXX";
+    int in_fd = mkstemp(path);
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    if (in_fd < 0 || null_fd < 0) return;
+    unlink(path);
+
+    for (size_t off = 0; off < BENCH_INPUT;) {
+        ssize_t n = write(in_fd, in + off, BENCH_INPUT - off);
+        if (n <= 0) return;
+        off += (size_t)n;
+    }
+    lseek(in_fd, 0, SEEK_SET);
+
+    double t = bench_now();
+    g_bench_sink += remap_fd(in_fd, null_fd, lut);
+    bench_report(name, BENCH_INPUT, bench_now() - t, "byte");
+
+    close(in_fd);
+    close(null_fd);
+}
+
+
+int main(void) {
+    char *in = malloc(BENCH_INPUT);
+    char *out = malloc(2 * BENCH_INPUT);
+    t_remap_lut lut;
+
+    if (!in || !out) return 1;
+    memset(out, 0, 2 * BENCH_INPUT);  /* Keeps page faults out of the measurements */
+
+    /* Theme swap: red to RGB, blue to bright blue, palette 196 to 160, RGB to nearest 256 */
+    remap_lut_init(&lut);
+    lut.base[1] = (t_remap_target){REMAP_TO_RGB, 0, {200, 10, 10}};
+    lut.base[4] = (t_remap_target){REMAP_TO_16, 12, {0, 0, 0}};
+    lut.palette[196] = (t_remap_target){REMAP_TO_256, 160, {0, 0, 0}};
+    lut.rgb_to_256 = 1;
+
+    printf("\nremap (%u MB, %d byte chunks)\n", BENCH_INPUT >> 20, BENCH_CHUNK);
+
+    /* Sparse: one rewritten sequence every 4000 bytes of text */
+    for (size_t i = 0; i < BENCH_INPUT; i++) in[i] = (char)('a' + i % 26);
+    for (size_t i = 0; i + 8 < BENCH_INPUT; i += 4000) memcpy(in + i, "\033[31m", 5);
+
+    /* First pass untimed: both buffers in the TLB and caches like for the filters */
+    memcpy(out, in, BENCH_INPUT);
+    double t = bench_now();
+    for (size_t off = 0; off < BENCH_INPUT; off += BENCH_CHUNK) memcpy(out + off, in + off, BENCH_CHUNK);
+    bench_report("memcpy per chunk (baseline)", BENCH_INPUT, bench_now() - t, "byte");
+    g_bench_sink += (unsigned char)out[BENCH_INPUT - 1];
+
+    bench_feed("remap_feed sparse", &lut, in, out);
+    bench_fd("remap_fd sparse", &lut, in);
+
+    /* Dense: two rewritten sequences every 20 bytes */
+    for (size_t i = 0; i + 20 < BENCH_INPUT; i += 20) memcpy(in + i, "\033[38;5;196mab\033[44mc", 18);
+    bench_feed("remap_feed dense", &lut, in, out);
+    bench_fd("remap_fd dense", &lut, in);
+
+    free(in);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/* Sixel encode time and bytes per frame on a 320x240 gradient, per palette size and dither */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+
+#include "color_lib.h"
+#include "color_sixel.h"
+#include "bench.h"
+
+#define BENCH_WIDTH 320
+#define BENCH_HEIGHT 240
+#define BENCH_FRAMES 40
+
+
+static int count_writer(void *ctx, const char *data, size_t len) {
+    (void)data;
+    *(size_t *)ctx += len;
+    return 1;
+}
+
+
+static void bench_image(const char *name, const t_rgb *pixels, size_t colors, SixelDither dither) {
+    size_t bytes = 0;
+    double t = bench_now();
+
+    for (int i = 0; i < BENCH_FRAMES; i++) {
+        g_bench_sink += sixel_write_image(count_writer, &bytes, pixels, BENCH_WIDTH, BENCH_HEIGHT, colors, dither);
+    }
+    t = bench_now() - t;
+    bench_report(name, BENCH_FRAMES, t, "frame");
+    printf("  %-36s %12zu bytes/frame\n", "", bytes / BENCH_FRAMES);
+}
+
+
+int main(void) {
+    t_rgb *pixels = malloc(BENCH_WIDTH * BENCH_HEIGHT * sizeof(t_rgb));
+    if (!pixels) return 1;
+
+    for (int y = 0; y < BENCH_HEIGHT; y++) {
+        for (int x = 0; x < BENCH_WIDTH; x++) {
+            t_rgb *p = &pixels[y * BENCH_WIDTH + x];
+            p->r = (uint8_t)(x * 255 / (BENCH_WIDTH - 1));
+            p->g = (uint8_t)(y * 255 / (BENCH_HEIGHT - 1));
+            p->b = (uint8_t)((x + y) & 0xFF);
+        }
+    }
+
+    printf("\nsixel (%dx%d gradient)\n", BENCH_WIDTH, BENCH_HEIGHT);
+    bench_image("16 colors", pixels, 16, SIXEL_DITHER_NONE);
+    bench_image("16 colors, ordered dither", pixels, 16, SIXEL_DITHER_ORDERED);
+    bench_image("256 colors", pixels, 256, SIXEL_DITHER_NONE);
+    bench_image("256 colors, ordered dither", pixels, 256, SIXEL_DITHER_ORDERED);
+
+    free(pixels);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/* Cost of output accounting: uninstrumented, instrumented but disabled, and enabled */
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_stats.h"
+#include "bench.h"
+
+#define BENCH_WRITES 200000
+#define BENCH_SEQUENCES 50000000
+
+
+/* One 4 KB chunk of colored log-like output */
+static size_t fill(char *buf, size_t size) {
+    static const char line[] = "\033[1;32mok\033[0m step \033[38;2;255;128;0m42\033[0m done\n";
+    size_t len = 0;
+
+    while (len + sizeof(line) - 1 <= size) {
+        memcpy(buf + len, line, sizeof(line) - 1);
+        len += sizeof(line) - 1;
+    }
+    return len;
+}
+
+
+static void bench_writes(const char *name, int fd, const char *buf, size_t len, int instrumented) {
+    double t = bench_now();
+
+    for (int i = 0; i < BENCH_WRITES; i++) {
+        g_bench_sink += (instrumented) ? color_stats_write(fd, buf, len) : write(fd, buf, len);
+    }
+    bench_report(name, (double)BENCH_WRITES * len, bench_now() - t, "byte");
+}
+
+
+static void bench_sequences(const char *name, int instrumented) {
+    double t = bench_now();
+
+    for (int i = 0; i < BENCH_SEQUENCES; i++) {
+        if (instrumented) color_stats_sequence(STATS_COLOR24, 19);
+        g_bench_sink += 19;
+    }
+    bench_report(name, BENCH_SEQUENCES, bench_now() - t, "call");
+}
+
+
+int main(void) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    char buf[4096];
+    size_t len = fill(buf, sizeof(buf));
+
+    if (null_fd < 0) return 1;
+
+    printf("\nstats (%zu-byte writes to /dev/null)\n", len);
+    bench_writes("write(), uninstrumented", null_fd, buf, len, 0);
+    color_stats_enable(0);
+    bench_writes("color_stats_write(), disabled", null_fd, buf, len, 1);
+    color_stats_enable(1);
+    bench_writes("color_stats_write(), enabled (scan)", null_fd, buf, len, 1);
+
+    color_stats_enable(0);
+    bench_sequences("no recording call", 0);
+    bench_sequences("color_stats_sequence(), disabled", 1);
+    color_stats_enable(1);
+    bench_sequences("color_stats_sequence(), enabled", 1);
+
+    close(null_fd);
+    return 0;
+}
@@ -0,0 +1,62 @@
+/* Theme startup: compiling the source vs mapping the cache, then lookups */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_theme.h"
+#include "bench.h"
+
+#define BENCH_STYLES 200
+#define BENCH_ROUNDS 2000
+#define BENCH_GETS 2000000
+
+
+static const char *const COLORS[] = {"#ff5555", "yellow on #303030", "rgb(80, 160, 255)", "dark_slate_gray", "on coral"};
+
+
+int main(void) {
+    char dir[] = "/tmp/color_bench_theme_XXXXXX";
+    char source[64], cache[64], name[32];
+
+    if (!mkdtemp(dir)) return 1;
+    snprintf(source, sizeof(source), "%s/theme.txt", dir);
+    snprintf(cache, sizeof(cache), "%s/theme.bin", dir);
+
+    FILE *f = fopen(source, "w");
+    if (!f) return 1;
+    for (int i = 0; i < BENCH_STYLES; i++) {
+        fprintf(f, "style_%d = %s%s\n", i, (i & 1) ? "bold " : "", COLORS[i % 5]);
+    }
+    fclose(f);
+
+    printf("\ntheme (%d styles)\n", BENCH_STYLES);
+
+    double t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) g_bench_sink += theme_compile(source, cache, GRADIENT_DEPTH_24);
+    bench_report("compile (parse + write)", BENCH_ROUNDS, bench_now() - t, "startup");
+
+    t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        t_theme *theme = theme_load(source, cache, GRADIENT_DEPTH_24);
+        g_bench_sink += (theme != NULL);
+        theme_close(theme);
+    }
+    bench_report("load warm cache (stat + map)", BENCH_ROUNDS, bench_now() - t, "startup");
+
+    t_theme *theme = theme_load(source, cache, GRADIENT_DEPTH_24);
+    if (!theme) return 1;
+    t = bench_now();
+    for (int i = 0; i < BENCH_GETS; i++) {
+        size_t len;
+        snprintf(name, sizeof(name), "style_%d", i % BENCH_STYLES);
+        g_bench_sink += (theme_get(theme, name, &len) != NULL) + len;
+    }
+    bench_report("get (snprintf + lookup)", BENCH_GETS, bench_now() - t, "lookup");
+    theme_close(theme);
+
+    unlink(source);
+    unlink(cache);
+    rmdir(dir);
+    return 0;
+}
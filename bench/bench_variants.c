@@ -0,0 +1,58 @@
+/*
+ * Same workload against every build of the library: static, shared, LTO and single header.
+ * The Makefile links this file once per variant; BENCH_VARIANT names it in the output.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#ifdef BENCH_SINGLE
+    #define COLOR_LIB_IMPLEMENTATION
+    #include "color_lib_single.h"
+#else
+    #include "color_lib.h"
+#endif
+
+#include "bench.h"
+
+#define BENCH_ROUNDS 2000000
+
+
+int main(void) {
+    char buf[8192];
+    double t;
+
+    /* Leading newline: the previous driver ends with the library reset sequences */
+    printf("\n%s\n", BENCH_VARIANT);
+
+    /* Literal arguments: the single-header encoders can fold them */
+    t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        g_bench_sink += put_color24(buf, COLOR_LAYER_FORE, 255, 128, 0);
+        g_bench_sink += (unsigned char)buf[3];
+    }
+    bench_report("put_color24 (literal)", BENCH_ROUNDS, bench_now() - t, "seq");
+
+    t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        g_bench_sink += put_color24(buf, COLOR_LAYER_BACK, (uint8_t)i, (uint8_t)(i >> 8), (uint8_t)(i >> 16));
+    }
+    bench_report("put_color24 (runtime)", BENCH_ROUNDS, bench_now() - t, "seq");
+
+    t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) g_bench_sink += put_color8(buf, COLOR_LAYER_FORE, (uint8_t)i);
+    bench_report("put_color8 (runtime)", BENCH_ROUNDS, bench_now() - t, "seq");
+
+    t = bench_now();
+    for (int i = 0; i < BENCH_ROUNDS; i++) g_bench_sink += rgb_to_color8((uint8_t)i, (uint8_t)(i >> 3), (uint8_t)(i >> 6));
+    bench_report("rgb_to_color8", BENCH_ROUNDS, bench_now() - t, "color");
+
+    const t_rgb stops[3] = {{0, 0, 255}, {0, 255, 0}, {255, 0, 0}};
+    int rounds = BENCH_ROUNDS / 100;
+    t = bench_now();
+    for (int i = 0; i < rounds; i++) {
+        g_bench_sink += gradient_render(buf, sizeof(buf), 80, stops, 3, GRADIENT_SPACE_RGB,
+                                        GRADIENT_DEPTH_24, COLOR_LAYER_BACK, " ");
+    }
+    bench_report("gradient_render 80 cells", rounds, bench_now() - t, "line");
+
+    return 0;
+}
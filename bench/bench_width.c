@@ -0,0 +1,45 @@
+/* str_width_n() throughput on pure ASCII and on mixed SGR / UTF-8 / wide text */
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_width.h"
+#include "bench.h"
+
+#define BENCH_BYTES (1 << 20)
+#define BENCH_ROUNDS 200
+
+
+static void bench_input(const char *name, const char *buf, size_t len) {
+    double t = bench_now();
+
+    for (int i = 0; i < BENCH_ROUNDS; i++) g_bench_sink += str_width_n(buf, len);
+    bench_report(name, (double)len * BENCH_ROUNDS, bench_now() - t, "byte");
+}
+
+
+/* Repeats 'chunk' to fill buf, returns the number of bytes written */
+static size_t fill(char *buf, size_t size, const char *chunk) {
+    size_t chunk_len = strlen(chunk);
+    size_t len = 0;
+
+    while (len + chunk_len <= size) {
+        memcpy(buf + len, chunk, chunk_len);
+        len += chunk_len;
+    }
+    return len;
+}
+
+
+int main(void) {
+    char *buf = malloc(BENCH_BYTES);
+    if (!buf) return 1;
+
+    printf("\nwidth\n");
+    bench_input("pure ASCII", buf, fill(buf, BENCH_BYTES, "The quick brown fox jumps over the lazy dog. "));
+    bench_input("mixed SGR / UTF-8 / wide", buf, fill(buf, BENCH_BYTES,
+        "\033[1;32mok\033[0m build \xC3\xA9t\xC3\xA9 \xE4\xB8\xAD\xE6\x96\x87 \033[38;5;208mwarn\033[0m \xF0\x9F\x98\x80 done. "));
+    free(buf);
+    return 0;
+}
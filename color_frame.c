@@ -0,0 +1,369 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_frame.h"
+#include "color_stats.h"
+#include "color_width.h"
+
+
+/* Rows of a frame handled by one thread, encoded into its private buffer */
+typedef struct s_frame_band {
+    uint16_t first_row;
+    uint16_t nb_rows;
+    char *buf;
+    size_t cap;
+    size_t len;
+} t_frame_band;
+
+
+/* Worker argument: the pool and the band index it owns (band 0 is the caller's, also used for small frames) */
+typedef struct s_frame_worker {
+    struct s_frame_pool *pool;
+    unsigned index;
+} t_frame_worker;
+
+
+struct s_frame_pool {
+    unsigned nb_threads;
+    pthread_t threads[FRAME_MAX_THREADS];
+    t_frame_worker workers[FRAME_MAX_THREADS];
+    unsigned nb_started;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation;
+    unsigned pending;
+    int stop;
+
+    /* Current job */
+    const t_frame_cell *cells;
+    uint16_t cols;
+    t_cursor_pos origin;
+    unsigned nb_bands;
+    t_frame_band bands[FRAME_MAX_THREADS];
+};
+
+
+static size_t frame_put_uint(char *dst, unsigned v) {
+    char tmp[8];
+    size_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    for (size_t i = 0; i < n; i++) dst[i] = tmp[n - 1 - i];
+    return n;
+}
+
+
+/* Absolute move: rows start at a known position whatever precedes them */
+static size_t frame_put_cup(char *dst, unsigned row, unsigned col) {
+    char *p = dst;
+    size_t esc_len = get_ansi_esc_len();
+
+    memcpy(p, get_ansi_esc_char(), esc_len);
+    p += esc_len;
+    *p++ = '[';
+    p += frame_put_uint(p, row);
+    *p++ = ';';
+    p += frame_put_uint(p, col);
+    *p++ = 'H';
+    return p - dst;
+}
+
+
+static size_t frame_put_utf8(char *dst, uint32_t cp) {
+    if (cp < 0x80) {
+        dst[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | cp >> 6);
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | cp >> 12);
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    if (cp > 0x10FFFF) cp = 0xFFFD;
+    dst[0] = (char)(0xF0 | cp >> 18);
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+
+static int same_rgb(const t_rgb *a, const t_rgb *b) {
+    return a->r == b->r && a->g == b->g && a->b == b->b;
+}
+
+
+size_t frame_size_max(uint16_t nb_rows, uint16_t cols) {
+    size_t cell = 2 * COLOR_SEQ_MAX + 4;
+    size_t row = get_ansi_esc_len() + 13 + (size_t)cols * cell;
+
+    return (size_t)nb_rows * row + 1;
+}
+
+
+size_t frame_encode_rows(char *dst, const t_frame_cell *cells, uint16_t cols,
+                         uint16_t first_row, uint16_t nb_rows, t_cursor_pos origin) {
+    if (!dst || !cells || origin.row == 0 || origin.col == 0) return 0;
+
+    char *p = dst;
+    size_t cup_bytes = 0;
+    size_t color_bytes = 0;
+    size_t nb_colors = 0;
+
+    for (unsigned y = first_row; y < (unsigned)first_row + nb_rows; y++) {
+        const t_frame_cell *row = cells + (size_t)y * cols;
+        const t_rgb *fg = NULL;
+        const t_rgb *bg = NULL;
+        size_t n;
+
+        n = frame_put_cup(p, origin.row + y, origin.col);
+        p += n;
+        cup_bytes += n;
+
+        for (uint16_t x = 0; x < cols; x++) {
+            const t_frame_cell *cell = &row[x];
+
+            if (!fg || !same_rgb(fg, &cell->fg)) {
+                n = put_color24(p, COLOR_LAYER_FORE, cell->fg.r, cell->fg.g, cell->fg.b);
+                p += n;
+                color_bytes += n;
+                nb_colors++;
+                fg = &cell->fg;
+            }
+            if (!bg || !same_rgb(bg, &cell->bg)) {
+                n = put_color24(p, COLOR_LAYER_BACK, cell->bg.r, cell->bg.g, cell->bg.b);
+                p += n;
+                color_bytes += n;
+                nb_colors++;
+                bg = &cell->bg;
+            }
+
+            /* A wide glyph covers the next cell; glyphs that would not take exactly their cells print a space */
+            uint32_t ch = cell->ch;
+            int width = (ch > 0x10FFFF) ? 1 : codepoint_width(ch);
+            if (width == 0 || (width == 2 && x + 1 >= cols)) ch = ' ';
+            else if (width == 2) x++;
+            p += frame_put_utf8(p, ch);
+        }
+    }
+    *p = '\0';
+
+    /* Counted in locals, recorded once per call into the encoding thread's counters */
+    if (color_stats_enabled()) {
+        t_color_stats delta = {0};
+        delta.sequences[STATS_CURSOR] = nb_rows;
+        delta.sequence_bytes[STATS_CURSOR] = cup_bytes;
+        delta.sequences[STATS_COLOR24] = nb_colors;
+        delta.sequence_bytes[STATS_COLOR24] = color_bytes;
+        delta.text_bytes = (size_t)(p - dst) - cup_bytes - color_bytes;
+        color_stats_add(&delta);
+    }
+
+    return p - dst;
+}
+
+
+static void encode_band(t_frame_pool *pool, t_frame_band *band) {
+    band->len = frame_encode_rows(band->buf, pool->cells, pool->cols, band->first_row, band->nb_rows, pool->origin);
+}
+
+
+static void *frame_worker(void *arg) {
+    t_frame_worker *worker = arg;
+    t_frame_pool *pool = worker->pool;
+    uint64_t seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->stop) pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->stop) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        unsigned nb_bands = pool->nb_bands;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (worker->index < nb_bands) encode_band(pool, &pool->bands[worker->index]);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+
+t_frame_pool *frame_pool_new(unsigned nb_threads) {
+    if (nb_threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nb_threads = (online > 0) ? (unsigned)online : 1;
+    }
+    if (nb_threads > FRAME_MAX_THREADS) nb_threads = FRAME_MAX_THREADS;
+
+    t_frame_pool *pool = calloc(1, sizeof(t_frame_pool));
+    if (!pool) return NULL;
+
+    pool->nb_threads = nb_threads;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    /* The caller encodes band 0, threads take bands 1..nb_threads-1 */
+    for (unsigned i = 1; i < nb_threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, frame_worker, &pool->workers[i]) != 0) {
+            frame_pool_free(pool);
+            return NULL;
+        }
+        pool->nb_started++;
+    }
+    return pool;
+}
+
+
+void frame_pool_free(t_frame_pool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 1; i <= pool->nb_started; i++) pthread_join(pool->threads[i], NULL);
+
+    for (unsigned i = 0; i < FRAME_MAX_THREADS; i++) free(pool->bands[i].buf);
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->start);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+
+static int reserve_band(t_frame_band *band, size_t size) {
+    if (band->cap >= size) return 1;
+
+    char *buf = realloc(band->buf, size);
+    if (!buf) return 0;
+
+    band->buf = buf;
+    band->cap = size;
+    return 1;
+}
+
+
+/* Writes every iovec, resuming after partial writes; one flush ending a frame */
+static ssize_t write_iov(int fd, struct iovec *iov, int count) {
+    ssize_t total = 0;
+    size_t syscalls = 0;
+
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            color_stats_flush(syscalls);
+            return -1;
+        }
+        total += n;
+
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    color_stats_flush(syscalls);
+    color_stats_frame();
+    return total;
+}
+
+
+ssize_t frame_write(t_frame_pool *pool, int fd, const t_frame_cell *cells, uint16_t rows, uint16_t cols,
+                    t_cursor_pos origin) {
+    if (!cells || origin.row == 0 || origin.col == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    struct iovec iov[FRAME_MAX_THREADS + 1];
+    size_t nb_cells = (size_t)rows * cols;
+
+    /* Small frames: waking the workers costs more than encoding. The pool's band 0 buffer is reused. */
+    if (!pool || pool->nb_threads == 1 || nb_cells < FRAME_PARALLEL_MIN) {
+        t_frame_band local = {0};
+        t_frame_band *band = (pool) ? &pool->bands[0] : &local;
+
+        if (!reserve_band(band, frame_size_max(rows, cols))) return -1;
+
+        iov[0].iov_base = band->buf;
+        iov[0].iov_len = frame_encode_rows(band->buf, cells, cols, 0, rows, origin);
+        iov[1].iov_base = Style.RESET;
+        iov[1].iov_len = COLOR_LEN(Style.RESET);
+        color_stats_sequence(STATS_STYLE, iov[1].iov_len);
+
+        ssize_t ret = write_iov(fd, iov, 2);
+        free(local.buf);
+        return ret;
+    }
+
+    unsigned nb_bands = (rows < pool->nb_threads) ? rows : pool->nb_threads;
+    uint16_t first = 0;
+
+    for (unsigned i = 0; i < nb_bands; i++) {
+        t_frame_band *band = &pool->bands[i];
+        band->first_row = first;
+        band->nb_rows = (uint16_t)(rows / nb_bands + (i < rows % nb_bands));
+        band->len = 0;
+        first += band->nb_rows;
+
+        if (!reserve_band(band, frame_size_max(band->nb_rows, cols))) return -1;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->cells = cells;
+    pool->cols = cols;
+    pool->origin = origin;
+    pool->nb_bands = nb_bands;
+    pool->pending = pool->nb_started;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    encode_band(pool, &pool->bands[0]);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < nb_bands; i++) {
+        iov[i].iov_base = pool->bands[i].buf;
+        iov[i].iov_len = pool->bands[i].len;
+    }
+    iov[nb_bands].iov_base = Style.RESET;
+    iov[nb_bands].iov_len = COLOR_LEN(Style.RESET);
+    color_stats_sequence(STATS_STYLE, iov[nb_bands].iov_len);
+
+    return write_iov(fd, iov, (int)nb_bands + 1);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file color_frame.h
+ * @brief Full-frame encoder for cell grids (heatmaps, images), parallel over row bands.
+ *
+ * Each row is encoded independently: it starts with an absolute cursor move and an
+ * unknown pen, so its first cell always sets both colors. Bands of rows can therefore
+ * be encoded by different threads into private buffers and concatenated as they are;
+ * the output is byte for byte the same whatever the number of threads. Whether more
+ * threads are faster depends on the free cores and the output fd: with one CPU they
+ * only add wake-up cost.
+ *
+ *     t_frame_pool *pool = frame_pool_new(0);     // one thread per online CPU
+ *     frame_write(pool, STDOUT_FILENO, cells, rows, cols, (t_cursor_pos){1, 1});
+ *     frame_pool_free(pool);
+ *
+ * frame_write() stitches the bands with writev() (no copy) and stays on the calling
+ * thread for frames below FRAME_PARALLEL_MIN cells, reusing the pool's buffer.
+ */
+
+#ifndef COLOR_FRAME_H
+#define COLOR_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Smallest frame (in cells) worth spreading across threads */
+#define FRAME_PARALLEL_MIN 4096
+
+/** Upper bound of the worker count */
+#define FRAME_MAX_THREADS 64
+
+/**
+ * @brief One cell: a glyph and its TrueColor pen.
+ */
+typedef struct s_frame_cell {
+    uint32_t ch; ///< Unicode code point; 0, controls and combining marks print a space. A wide glyph also covers the next cell, whose glyph is skipped.
+    t_rgb fg;
+    t_rgb bg;
+} t_frame_cell;
+
+/**
+ * @brief Worker pool, reusable across frames (not shared by concurrent frame_write() calls).
+ */
+typedef struct s_frame_pool t_frame_pool;
+
+/**
+ * @brief Computes the buffer size frame_encode_rows() needs, NUL terminator included.
+ */
+size_t frame_size_max(uint16_t nb_rows, uint16_t cols);
+
+/**
+ * @brief Encodes rows [first_row, first_row + nb_rows) of a frame on the calling thread.
+ * @param cells rows * cols cells, row-major.
+ * @param origin Screen position of the frame's top-left cell (1-based).
+ * @param dst Destination, see frame_size_max().
+ * @return Number of bytes written (NUL excluded), 0 on invalid arguments.
+ */
+size_t frame_encode_rows(char *dst, const t_frame_cell *cells, uint16_t cols,
+                         uint16_t first_row, uint16_t nb_rows, t_cursor_pos origin);
+
+/**
+ * @brief Starts a pool of encoding threads.
+ * @param nb_threads Threads taking part in an encode, the caller included (0: online CPUs).
+ * @return The pool, or NULL on failure.
+ */
+t_frame_pool *frame_pool_new(unsigned nb_threads);
+
+/**
+ * @brief Stops the threads and frees the pool and its band buffers.
+ */
+void frame_pool_free(t_frame_pool *pool);
+
+/**
+ * @brief Encodes a whole frame and writes it to fd, followed by a style reset.
+ * * Small frames, or a NULL pool, are encoded on the calling thread.
+ * @return Number of bytes written, or -1 on error (errno set).
+ */
+ssize_t frame_write(t_frame_pool *pool, int fd, const t_frame_cell *cells, uint16_t rows, uint16_t cols,
+                    t_cursor_pos origin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_FRAME_H */
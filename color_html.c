@@ -0,0 +1,469 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_vt.h"
+#include "color_html.h"
+
+
+#define HTML_CHUNK 16384
+
+
+/* Bytes that end a plain text run: ESC, HTML specials and control characters but LF and TAB */
+static const uint8_t HTML_SPECIAL[256] = {
+    [0x00] = 1, [0x01] = 1, [0x02] = 1, [0x03] = 1, [0x04] = 1, [0x05] = 1, [0x06] = 1, [0x07] = 1,
+    [0x08] = 1, [0x0B] = 1, [0x0C] = 1, [0x0D] = 1, [0x0E] = 1, [0x0F] = 1,
+    [0x10] = 1, [0x11] = 1, [0x12] = 1, [0x13] = 1, [0x14] = 1, [0x15] = 1, [0x16] = 1, [0x17] = 1,
+    [0x18] = 1, [0x19] = 1, [0x1A] = 1, [0x1B] = 1, [0x1C] = 1, [0x1D] = 1, [0x1E] = 1, [0x1F] = 1,
+    ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 1, ['\''] = 1, [0x7F] = 1
+};
+
+
+/* xterm defaults for the 16 base colors */
+static const uint32_t HTML_BASE_COLORS[16] = {
+    0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+    0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF
+};
+
+
+static const uint8_t HTML_CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+
+
+typedef struct s_html_attr {
+    uint16_t attr;
+    const char *css_class;
+    const char *inline_style;
+} t_html_attr;
+
+
+/* Decorations (underline, strike, overline) are combined separately, text-decoration-line is one property */
+static const t_html_attr HTML_ATTRS[] = {
+    {VT_ATTR_BOLD, "ansi-bold", "font-weight:bold;"},
+    {VT_ATTR_DIM, "ansi-dim", "opacity:.5;"},
+    {VT_ATTR_ITALIC, "ansi-italic", "font-style:italic;"},
+    {VT_ATTR_BLINK, "ansi-blink", ""},
+    {VT_ATTR_HIDDEN, "ansi-hidden", "visibility:hidden;"},
+    {VT_ATTR_FRAMED, "ansi-framed", "outline:1px solid;"},
+    {VT_ATTR_ENCIRCLED, "ansi-encircled", "border:1px solid;border-radius:.5em;"}
+};
+
+#define NB_HTML_ATTRS (sizeof(HTML_ATTRS) / sizeof(HTML_ATTRS[0]))
+
+
+static uint32_t palette_rgb(uint32_t index) {
+    if (index < 16) return HTML_BASE_COLORS[index];
+    if (index < 232) {
+        index -= 16;
+        return (uint32_t)HTML_CUBE_LEVELS[index / 36] << 16
+             | (uint32_t)HTML_CUBE_LEVELS[(index / 6) % 6] << 8
+             | HTML_CUBE_LEVELS[index % 6];
+    }
+    uint32_t gray = 8 + (index - 232) * 10;
+    return gray << 16 | gray << 8 | gray;
+}
+
+
+static int color_equal(const t_vt_color *a, const t_vt_color *b) {
+    return a->kind == b->kind && a->value == b->value;
+}
+
+
+static int pen_equal(const t_vt_pen *a, const t_vt_pen *b) {
+    return a->attrs == b->attrs && color_equal(&a->fg, &b->fg) && color_equal(&a->bg, &b->bg)
+        && color_equal(&a->ul, &b->ul);
+}
+
+
+static int pen_is_default(const t_vt_pen *pen) {
+    return pen->attrs == 0 && pen->fg.kind == VT_COLOR_DEFAULT && pen->bg.kind == VT_COLOR_DEFAULT
+        && pen->ul.kind == VT_COLOR_DEFAULT;
+}
+
+
+void html_init(t_html_conv *conv, HtmlStyleMode mode) {
+    memset(conv, 0, sizeof(t_html_conv));
+    conv->mode = mode;
+    conv->state = VT_STATE_GROUND;
+}
+
+
+/* --- Span rendering --- */
+
+static char *put_str(char *p, const char *s) {
+    size_t len = strlen(s);
+
+    memcpy(p, s, len);
+    return p + len;
+}
+
+
+static char *put_hex(char *p, uint32_t rgb) {
+    static const char DIGITS[] = "0123456789abcdef";
+
+    *p++ = '#';
+    for (int shift = 20; shift >= 0; shift -= 4) *p++ = DIGITS[(rgb >> shift) & 0xF];
+    return p;
+}
+
+
+/* "ansi-fg196 " */
+static char *put_class_index(char *p, const char *prefix, uint32_t v) {
+    p = put_str(p, prefix);
+    if (v >= 100) *p++ = (char)('0' + v / 100);
+    if (v >= 10) *p++ = (char)('0' + (v / 10) % 10);
+    *p++ = (char)('0' + v % 10);
+    *p++ = ' ';
+    return p;
+}
+
+
+static const char *decoration_line(uint16_t attrs) {
+    static const char *LINES[8] = {
+        NULL, "underline", "line-through", "underline line-through",
+        "overline", "underline overline", "line-through overline", "underline line-through overline"
+    };
+    int bits = ((attrs & (VT_ATTR_UNDERLINE | VT_ATTR_DOUBLE_UNDERLINE)) ? 1 : 0)
+             | ((attrs & VT_ATTR_STRIKETHROUGH) ? 2 : 0)
+             | ((attrs & VT_ATTR_OVERLINE) ? 4 : 0);
+
+    return LINES[bits];
+}
+
+
+/* A color slot after reverse video: 'inverse' when the swapped-in color is the default */
+typedef struct s_html_slot {
+    const t_vt_color *color;
+    unsigned char inverse;
+} t_html_slot;
+
+
+static char *put_classes(char *p, const t_vt_pen *pen, const t_html_slot *fg, const t_html_slot *bg) {
+    char *start = p;
+
+    p = put_str(p, " class=\"");
+    if (fg->inverse) p = put_str(p, "ansi-fg-inverse ");
+    else if (fg->color->kind == VT_COLOR_INDEX) p = put_class_index(p, "ansi-fg", fg->color->value);
+    if (bg->inverse) p = put_str(p, "ansi-bg-inverse ");
+    else if (bg->color->kind == VT_COLOR_INDEX) p = put_class_index(p, "ansi-bg", bg->color->value);
+    if (pen->ul.kind == VT_COLOR_INDEX) p = put_class_index(p, "ansi-ul", pen->ul.value);
+
+    for (size_t i = 0; i < NB_HTML_ATTRS; i++) {
+        if (!(pen->attrs & HTML_ATTRS[i].attr)) continue;
+        p = put_str(p, HTML_ATTRS[i].css_class);
+        *p++ = ' ';
+    }
+    if (pen->attrs & (VT_ATTR_UNDERLINE | VT_ATTR_DOUBLE_UNDERLINE)) p = put_str(p, "ansi-underline ");
+    if (pen->attrs & VT_ATTR_DOUBLE_UNDERLINE) p = put_str(p, "ansi-double ");
+    if (pen->attrs & VT_ATTR_STRIKETHROUGH) p = put_str(p, "ansi-strike ");
+    if (pen->attrs & VT_ATTR_OVERLINE) p = put_str(p, "ansi-overline ");
+
+    /* Nothing but RGB colors: drop the empty attribute */
+    if (p == start + 8) return start;
+    p[-1] = '"';
+    return p;
+}
+
+
+static char *put_inline(char *p, const t_vt_pen *pen, const t_html_slot *fg, const t_html_slot *bg, int classes) {
+    char *start = p;
+
+    p = put_str(p, " style=\"");
+    if (fg->inverse && !classes) p = put_str(p, "color:var(--ansi-bg,#000);");
+    else if (fg->color->kind == VT_COLOR_RGB || (!classes && fg->color->kind == VT_COLOR_INDEX)) {
+        uint32_t rgb = (fg->color->kind == VT_COLOR_RGB) ? fg->color->value : palette_rgb(fg->color->value);
+        p = put_str(put_hex(put_str(p, "color:"), rgb), ";");
+    }
+    if (bg->inverse && !classes) p = put_str(p, "background-color:var(--ansi-fg,#fff);");
+    else if (bg->color->kind == VT_COLOR_RGB || (!classes && bg->color->kind == VT_COLOR_INDEX)) {
+        uint32_t rgb = (bg->color->kind == VT_COLOR_RGB) ? bg->color->value : palette_rgb(bg->color->value);
+        p = put_str(put_hex(put_str(p, "background-color:"), rgb), ";");
+    }
+    if (pen->ul.kind == VT_COLOR_RGB || (!classes && pen->ul.kind == VT_COLOR_INDEX)) {
+        uint32_t rgb = (pen->ul.kind == VT_COLOR_RGB) ? pen->ul.value : palette_rgb(pen->ul.value);
+        p = put_str(put_hex(put_str(p, "text-decoration-color:"), rgb), ";");
+    }
+
+    if (!classes) {
+        for (size_t i = 0; i < NB_HTML_ATTRS; i++) {
+            if (pen->attrs & HTML_ATTRS[i].attr) p = put_str(p, HTML_ATTRS[i].inline_style);
+        }
+        const char *line = decoration_line(pen->attrs);
+        if (line) p = put_str(put_str(put_str(p, "text-decoration-line:"), line), ";");
+        if (pen->attrs & VT_ATTR_DOUBLE_UNDERLINE) p = put_str(p, "text-decoration-style:double;");
+    }
+
+    if (p == start + 8) return start;
+    p[-1] = '"';
+    return p;
+}
+
+
+static char *put_open_tag(char *p, const t_vt_pen *pen, HtmlStyleMode mode) {
+    t_html_slot fg = {&pen->fg, 0};
+    t_html_slot bg = {&pen->bg, 0};
+
+    if (pen->attrs & VT_ATTR_REVERSE) {
+        fg.color = &pen->bg;
+        bg.color = &pen->fg;
+        fg.inverse = (pen->bg.kind == VT_COLOR_DEFAULT);
+        bg.inverse = (pen->fg.kind == VT_COLOR_DEFAULT);
+    }
+
+    p = put_str(p, "<span");
+    if (mode == HTML_STYLE_CLASSES) {
+        p = put_classes(p, pen, &fg, &bg);
+        p = put_inline(p, pen, &fg, &bg, 1);
+    } else {
+        p = put_inline(p, pen, &fg, &bg, 0);
+    }
+    *p++ = '>';
+    return p;
+}
+
+
+/* Closes and opens spans so the output pen matches the input pen */
+static char *transition(t_html_conv *conv, char *p) {
+    if (pen_equal(&conv->pen, &conv->open_pen)) return p;
+
+    if (conv->span_open) p = put_str(p, "</span>");
+    conv->span_open = !pen_is_default(&conv->pen);
+    if (conv->span_open) p = put_open_tag(p, &conv->pen, conv->mode);
+    conv->open_pen = conv->pen;
+    return p;
+}
+
+
+/* --- Tokenizer --- */
+
+/* Same tokenizer as the emulator, only SGR is rendered */
+static void html_csi_byte(t_html_conv *conv, unsigned char c) {
+    int final = vt_csi_byte(&conv->csi, c);
+
+    if (final == 0x1B) {
+        conv->state = VT_STATE_ESC;
+    } else if (final) {
+        conv->state = VT_STATE_GROUND;
+        if (final == 'm' && !conv->csi.private_marker) {
+            vt_pen_apply_sgr(&conv->pen, conv->csi.params, conv->csi.nb_params);
+        }
+    }
+}
+
+
+static void html_esc_byte(t_html_conv *conv, unsigned char c) {
+    conv->state = VT_STATE_GROUND;
+
+    if (c == '[') {
+        conv->state = VT_STATE_CSI;
+        vt_csi_reset(&conv->csi);
+    } else if (c == ']' || c == 'P' || c == '_' || c == '^') {
+        conv->state = VT_STATE_STRING;
+    }
+    /* Other two-byte sequences (ESC 7, ESC 8, ESC c...) have no HTML rendering */
+}
+
+
+static char *put_special(char *p, unsigned char c) {
+    switch (c) {
+        case '&': return put_str(p, "&amp;");
+        case '<': return put_str(p, "&lt;");
+        case '>': return put_str(p, "&gt;");
+        case '"': return put_str(p, "&quot;");
+        case '\'': return put_str(p, "&#39;");
+        default: return p; /* Control characters are dropped */
+    }
+}
+
+
+size_t html_convert(t_html_conv *conv, const char *src, size_t len, size_t *consumed, char *dst, size_t size) {
+    const unsigned char *s = (const unsigned char *)src;
+    char *p = dst;
+    char *end = dst + size;
+    size_t i = 0;
+
+    if (!conv || !src || !dst || size < HTML_SPAN_MAX) {
+        if (consumed) *consumed = 0;
+        return 0;
+    }
+
+    /* Each step needs room for "</span>", an opening tag and one entity */
+    while (i < len && (size_t)(end - p) >= HTML_SPAN_MAX) {
+        unsigned char c = s[i];
+
+        switch (conv->state) {
+        case VT_STATE_GROUND:
+            if (c == 0x1B) {
+                conv->state = VT_STATE_ESC;
+                i++;
+                break;
+            }
+            if (HTML_SPECIAL[c] && c != '&' && c != '<' && c != '>' && c != '"' && c != '\'') {
+                i++;
+                break;
+            }
+
+            p = transition(conv, p);
+            if (HTML_SPECIAL[c]) {
+                p = put_special(p, c);
+                i++;
+                break;
+            }
+
+            /* Plain run, copied as is (UTF-8 included) */
+            size_t room = (size_t)(end - p) - HTML_SPAN_MAX + 1;
+            size_t run = 0;
+            while (run < room && i + run < len && !HTML_SPECIAL[s[i + run]]) run++;
+            memcpy(p, s + i, run);
+            p += run;
+            i += run;
+            break;
+
+        case VT_STATE_ESC:
+            html_esc_byte(conv, c);
+            i++;
+            break;
+
+        case VT_STATE_CSI:
+            html_csi_byte(conv, c);
+            i++;
+            break;
+
+        case VT_STATE_STRING:
+            if (c == 0x07) conv->state = VT_STATE_GROUND;
+            else if (c == 0x1B) conv->state = VT_STATE_STRING_ESC;
+            i++;
+            break;
+
+        case VT_STATE_STRING_ESC:
+            conv->state = (c == '\\') ? VT_STATE_GROUND : VT_STATE_STRING;
+            i++;
+            break;
+        }
+    }
+
+    if (consumed) *consumed = i;
+    return p - dst;
+}
+
+
+size_t html_finish(t_html_conv *conv, char *dst, size_t size) {
+    size_t len = 0;
+
+    if (!conv) return 0;
+
+    if (conv->span_open && dst && size >= 8) {
+        memcpy(dst, "</span>", 7);
+        len = 7;
+    }
+    html_init(conv, conv->mode);
+    return len;
+}
+
+
+static int html_write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+
+int html_convert_fd(int in_fd, int out_fd, HtmlStyleMode mode) {
+    char in[HTML_CHUNK];
+    char out[4 * HTML_CHUNK];
+    t_html_conv conv;
+
+    html_init(&conv, mode);
+    for (;;) {
+        ssize_t n = read(in_fd, in, HTML_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return 0;
+        if (n == 0) break;
+
+        size_t off = 0;
+        while (off < (size_t)n) {
+            size_t used;
+            size_t w = html_convert(&conv, in + off, (size_t)n - off, &used, out, sizeof(out));
+            if (!html_write_all(out_fd, out, w)) return 0;
+            off += used;
+        }
+    }
+
+    size_t w = html_finish(&conv, out, sizeof(out));
+    return html_write_all(out_fd, out, w);
+}
+
+
+/* --- Stylesheet --- */
+
+/* Appends to dst when it is not NULL, counts in any case */
+static size_t css_rule(char *dst, size_t pos, size_t size, const char *format, ...) {
+    va_list args;
+    char *out = (dst && pos < size) ? dst + pos : NULL;
+    size_t room = (dst && pos < size) ? size - pos : 0;
+
+    va_start(args, format);
+    int n = vsnprintf(out, room, format, args);
+    va_end(args);
+
+    return (n > 0) ? (size_t)n : 0;
+}
+
+
+static size_t render_css(char *dst, size_t size) {
+    size_t pos = 0;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t rgb = palette_rgb(i);
+        pos += css_rule(dst, pos, size, ".ansi-fg%u{color:#%06x}\n", i, rgb);
+        pos += css_rule(dst, pos, size, ".ansi-bg%u{background-color:#%06x}\n", i, rgb);
+        pos += css_rule(dst, pos, size, ".ansi-ul%u{text-decoration-color:#%06x}\n", i, rgb);
+    }
+
+    pos += css_rule(dst, pos, size, ".ansi-fg-inverse{color:var(--ansi-bg,#000)}\n");
+    pos += css_rule(dst, pos, size, ".ansi-bg-inverse{background-color:var(--ansi-fg,#fff)}\n");
+    for (size_t i = 0; i < NB_HTML_ATTRS; i++) {
+        if (HTML_ATTRS[i].attr == VT_ATTR_BLINK) continue;
+        pos += css_rule(dst, pos, size, ".%s{%s}\n", HTML_ATTRS[i].css_class, HTML_ATTRS[i].inline_style);
+    }
+    pos += css_rule(dst, pos, size, ".ansi-blink{animation:ansi-blink 1s steps(1) infinite}\n");
+    pos += css_rule(dst, pos, size, "@keyframes ansi-blink{50%%{opacity:0}}\n");
+
+    /* One rule per decoration combination, text-decoration-line takes them all at once */
+    static const char *DECO_CLASSES[3] = {".ansi-underline", ".ansi-strike", ".ansi-overline"};
+    static const uint16_t DECO_ATTRS[3] = {VT_ATTR_UNDERLINE, VT_ATTR_STRIKETHROUGH, VT_ATTR_OVERLINE};
+    for (int combo = 1; combo < 8; combo++) {
+        uint16_t attrs = 0;
+        for (int k = 0; k < 3; k++) {
+            if (!(combo & (1 << k))) continue;
+            pos += css_rule(dst, pos, size, "%s", DECO_CLASSES[k]);
+            attrs |= DECO_ATTRS[k];
+        }
+        pos += css_rule(dst, pos, size, "{text-decoration-line:%s}\n", decoration_line(attrs));
+    }
+    pos += css_rule(dst, pos, size, ".ansi-double{text-decoration-style:double}\n");
+
+    return pos;
+}
+
+
+size_t html_css_size(void) {
+    return render_css(NULL, 0) + 1;
+}
+
+
+size_t html_css(char *dst, size_t size) {
+    if (!dst || size < html_css_size()) return 0;
+    return render_css(dst, size);
+}
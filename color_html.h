@@ -0,0 +1,96 @@
+/**
+ * @file color_html.h
+ * @brief Streaming ANSI to HTML converter for archived terminal output.
+ *
+ * Tracks the pen through the same SGR rules as the VT emulator (4-bit Fore/Back, Style
+ * attributes, 8-bit, 24-bit and underline colors) and emits a <span> only when text is
+ * printed with a pen different from the open one, so consecutive SGRs collapse into one
+ * transition. Text is HTML-escaped; other sequences (cursor moves, erasing, OSC/DCS strings)
+ * and control characters except LF and TAB are dropped.
+ *
+ * Memory is constant: the converter state is a fixed-size struct, input and output go
+ * through caller buffers of any size and sequences may be split across chunks.
+ * The output is an HTML fragment, meant to sit in a <pre> block.
+ */
+
+#ifndef COLOR_HTML_H
+#define COLOR_HTML_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+#include "color_vt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest opening tag, and the smallest output buffer html_convert() accepts */
+#define HTML_SPAN_MAX 512
+
+/**
+ * @brief How span colors and attributes are written.
+ */
+typedef enum {
+    HTML_STYLE_CLASSES = 0, ///< class="ansi-fg1 ansi-bold", see html_css(); RGB colors stay inline
+    HTML_STYLE_INLINE  = 1  ///< style="color:#cd0000;font-weight:bold", self-contained
+} HtmlStyleMode;
+
+/**
+ * @brief Converter state.
+ */
+typedef struct s_html_conv {
+    HtmlStyleMode mode;
+    t_vt_pen pen;        /**< Pen set by the input */
+    t_vt_pen open_pen;   /**< Pen of the open span */
+    unsigned char span_open;
+
+    /* Tokenizer */
+    VtState state;
+    t_vt_csi csi;
+} t_html_conv;
+
+/**
+ * @brief Initializes (or resets) a converter.
+ */
+void html_init(t_html_conv *conv, HtmlStyleMode mode);
+
+/**
+ * @brief Converts input until it is consumed or the output buffer is full.
+ * @param consumed Receives the number of input bytes processed; call again with the rest.
+ * @param size Size of dst, at least HTML_SPAN_MAX.
+ * @return Number of bytes written to dst (not NUL-terminated).
+ */
+size_t html_convert(t_html_conv *conv, const char *src, size_t len, size_t *consumed, char *dst, size_t size);
+
+/**
+ * @brief Closes the open span and resets the converter.
+ * @param size Size of dst, at least 8.
+ * @return Number of bytes written.
+ */
+size_t html_finish(t_html_conv *conv, char *dst, size_t size);
+
+/**
+ * @brief Converts everything readable from in_fd to out_fd (fragment only), in fixed-size chunks.
+ * @return 1 on success, 0 on I/O error.
+ */
+int html_convert_fd(int in_fd, int out_fd, HtmlStyleMode mode);
+
+/**
+ * @brief Computes the buffer size html_css() needs, NUL terminator included.
+ */
+size_t html_css_size(void);
+
+/**
+ * @brief Writes the stylesheet for HTML_STYLE_CLASSES (xterm palette, attributes).
+ * * Default colors come from the --ansi-fg / --ansi-bg custom properties.
+ * @return Number of bytes written (NUL excluded), or 0 if dst is too small.
+ */
+size_t html_css(char *dst, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_HTML_H */
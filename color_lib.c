@@ -1,4 +1,6 @@
 #define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <signal.h>
@@ -6,6 +8,7 @@
 #include <unistd.h>
 #include <time.h>
 
+#define COLOR_LIB_ENCODERS
 #include "color_lib.h"
 
 
@@ -71,6 +74,7 @@ void print(char *msg) {
 
 
 static const char *g_ansi_esc_char = "\033";
+static size_t g_ansi_esc_len = 1;
 static unsigned char g_cursor_auto_show = 1;
 static unsigned char g_auto_clean = 1;
 
@@ -299,6 +303,9 @@ static const char *RAW_MISC_CODES[NB_MISC] = {
         
     "[65m", // NO_IDEOGRAM_ATTRIBUTES
     "[65m", // IDEOGRAM_RESET_ATTRIBUTES
+
+    "[73m", // SUPERSCRIPT
+    "[74m", // SUBSCRIPT
 };
 
 
@@ -328,36 +335,35 @@ char *custom_code(unsigned char code) {
 
 
 char *cursor_cup(uint16_t row, uint16_t column) {
-    if (!(1 <= row && row <= 999)) return NULL;
-    if (!(1 <= column && column <= 999)) return NULL;
+    if (row < 1 || column < 1) return NULL;
 
     return gc_asprintf2("%s[%d;%dH", row, column);
 }
 
 
 char *cursor_cuu(uint16_t n) {
-    if (!(1 <= n && n <= 999)) return NULL;
+    if (n < 1) return NULL;
 
     return gc_asprintf("%s[%dA", n);
 }
 
 
 char *cursor_cud(uint16_t n) {
-    if (!(1 <= n && n <= 999)) return NULL;
+    if (n < 1) return NULL;
     
     return gc_asprintf("%s[%dB", n);
 }
 
 
 char *cursor_cuf(uint16_t n) {
-    if (!(1 <= n && n <= 999)) return NULL;
+    if (n < 1) return NULL;
     
     return gc_asprintf("%s[%dC", n);
 }
 
 
 char *cursor_cub(uint16_t n) {
-    if (!(1 <= n && n <= 999)) return NULL;
+    if (n < 1) return NULL;
     
     return gc_asprintf("%s[%dD", n);
 }
@@ -391,10 +397,510 @@ char *underline_color24(uint8_t r, uint8_t g, uint8_t b) {
 }
 
 
+/* --- Buffer versions of the generators --- */
+
+static size_t put_u16(char *p, uint16_t v);
+
+static size_t put_csi_arg(char *dst, uint16_t n, char final) {
+    char *p = dst;
+
+    memcpy(p, g_ansi_esc_char, g_ansi_esc_len);
+    p += g_ansi_esc_len;
+    *p++ = '[';
+    p += put_u16(p, n);
+    *p++ = final;
+    return p - dst;
+}
+
+
+size_t put_custom_code(char *dst, unsigned char code) {
+    return put_csi_arg(dst, code, 'm');
+}
+
+
+size_t put_cursor_cup(char *dst, uint16_t row, uint16_t column) {
+    if (row < 1 || column < 1) return 0;
+
+    size_t len = put_csi_arg(dst, row, ';');
+    len += put_u16(dst + len, column);
+    dst[len++] = 'H';
+    return len;
+}
+
+
+size_t put_cursor_cuu(char *dst, uint16_t n) {
+    return (n < 1) ? 0 : put_csi_arg(dst, n, 'A');
+}
+
+
+size_t put_cursor_cud(char *dst, uint16_t n) {
+    return (n < 1) ? 0 : put_csi_arg(dst, n, 'B');
+}
+
+
+size_t put_cursor_cuf(char *dst, uint16_t n) {
+    return (n < 1) ? 0 : put_csi_arg(dst, n, 'C');
+}
+
+
+size_t put_cursor_cub(char *dst, uint16_t n) {
+    return (n < 1) ? 0 : put_csi_arg(dst, n, 'D');
+}
+
+
+size_t get_ansi_esc_len(void) {
+    return g_ansi_esc_len;
+}
+
+
+/* --- Cursor Motion Planner --- */
+
+/* Each helper returns the byte count of its sequence and only writes it when p is not NULL */
+
+static size_t put_u16(char *p, uint16_t v) {
+    char digits[5];
+    size_t n = 0;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+
+    if (p) {
+        for (size_t i = 0; i < n; i++) p[i] = digits[n - 1 - i];
+    }
+    return n;
+}
+
+
+/* ESC [ n <final>, with n omitted when it equals the default of 1 */
+static size_t put_csi_n(char *p, uint16_t n, char final) {
+    size_t len = g_ansi_esc_len + 2;
+
+    if (p) {
+        memcpy(p, g_ansi_esc_char, g_ansi_esc_len);
+        p[g_ansi_esc_len] = '[';
+    }
+    if (n != 1) len += put_u16((p) ? p + g_ansi_esc_len + 1 : NULL, n);
+    if (p) p[len - 1] = final;
+    return len;
+}
+
+
+static size_t put_cup(char *p, uint16_t row, uint16_t col) {
+    if (col == 1) return put_csi_n(p, row, 'H');
+
+    size_t len = g_ansi_esc_len + 1;
+    if (p) {
+        memcpy(p, g_ansi_esc_char, g_ansi_esc_len);
+        p[g_ansi_esc_len] = '[';
+    }
+    if (row != 1) len += put_u16((p) ? p + len : NULL, row);
+    if (p) p[len] = ';';
+    len++;
+    len += put_u16((p) ? p + len : NULL, col);
+    if (p) p[len] = 'H';
+    return len + 1;
+}
+
+
+static size_t put_repeat(char *p, char c, size_t n) {
+    if (p) memset(p, c, n);
+    return n;
+}
+
+
+/* Vertical move keeping the column: CUU, CUD or VPA */
+static size_t put_vertical(char *p, uint16_t from, uint16_t to) {
+    if (from == to) return 0;
+
+    size_t rel = (to < from) ? put_csi_n(NULL, from - to, 'A') : put_csi_n(NULL, to - from, 'B');
+    size_t abs = put_csi_n(NULL, to, 'd');
+
+    if (abs < rel) return put_csi_n(p, to, 'd');
+    return (to < from) ? put_csi_n(p, from - to, 'A') : put_csi_n(p, to - from, 'B');
+}
+
+
+static int cells_known(const char *cells, size_t nb_cells, uint16_t from, uint16_t to) {
+    if (!cells || (size_t)to - 1 > nb_cells) return 0;
+    for (size_t i = from - 1; i < (size_t)to - 1; i++) {
+        if ((unsigned char)cells[i] < 0x20 || (unsigned char)cells[i] >= 0x7F) return 0;
+    }
+    return 1;
+}
+
+
+/* Horizontal move on the current row: CUF, CUB, backspaces, CHA or reprinting known cells */
+static size_t put_horizontal(char *p, uint16_t from, uint16_t to, const char *cells, size_t nb_cells) {
+    if (from == to) return 0;
+
+    size_t best;
+    int how;
+
+    best = put_csi_n(NULL, to, 'G');
+    how = 0;
+    if (to > from) {
+        if (put_csi_n(NULL, to - from, 'C') < best) { best = put_csi_n(NULL, to - from, 'C'); how = 1; }
+        if ((size_t)(to - from) < best && cells_known(cells, nb_cells, from, to)) { best = to - from; how = 2; }
+    } else {
+        if (put_csi_n(NULL, from - to, 'D') < best) { best = put_csi_n(NULL, from - to, 'D'); how = 3; }
+        if ((size_t)(from - to) < best) { best = from - to; how = 4; }
+    }
+
+    if (!p) return best;
+    switch (how) {
+        case 1: return put_csi_n(p, to - from, 'C');
+        case 2: memcpy(p, cells + from - 1, to - from); return best;
+        case 3: return put_csi_n(p, from - to, 'D');
+        case 4: return put_repeat(p, '\b', from - to);
+        default: return put_csi_n(p, to, 'G');
+    }
+}
+
+
+typedef enum {
+    MOVE_CUP,      // Absolute position
+    MOVE_RELATIVE, // Vertical then horizontal from the current column
+    MOVE_CR,       // Carriage return, vertical, then horizontal from column 1
+    MOVE_LF        // Line feeds, carriage return, then horizontal from column 1
+} CursorMoveKind;
+
+
+size_t put_cursor_move(char *dst, t_cursor_pos from, t_cursor_pos to, const char *cells, size_t nb_cells) {
+    if (from.row == 0 || from.col == 0 || to.row == 0 || to.col == 0) return 0;
+
+    CursorMoveKind kind = MOVE_CUP;
+    size_t best = put_cup(NULL, to.row, to.col);
+    size_t cost;
+
+    cost = put_vertical(NULL, from.row, to.row) + put_horizontal(NULL, from.col, to.col, cells, nb_cells);
+    if (cost < best) { best = cost; kind = MOVE_RELATIVE; }
+
+    cost = 1 + put_vertical(NULL, from.row, to.row) + put_horizontal(NULL, 1, to.col, cells, nb_cells);
+    if (cost < best) { best = cost; kind = MOVE_CR; }
+
+    /* With ONLCR a line feed also returns the carriage, so it is only used followed by CR */
+    if (to.row > from.row) {
+        cost = (to.row - from.row) + 1 + put_horizontal(NULL, 1, to.col, cells, nb_cells);
+        if (cost < best) { best = cost; kind = MOVE_LF; }
+    }
+
+    if (!dst) return best;
+
+    char *p = dst;
+    switch (kind) {
+        case MOVE_RELATIVE:
+            p += put_vertical(p, from.row, to.row);
+            p += put_horizontal(p, from.col, to.col, cells, nb_cells);
+            break;
+        case MOVE_CR:
+            *p++ = '\r';
+            p += put_vertical(p, from.row, to.row);
+            p += put_horizontal(p, 1, to.col, cells, nb_cells);
+            break;
+        case MOVE_LF:
+            p += put_repeat(p, '\n', to.row - from.row);
+            *p++ = '\r';
+            p += put_horizontal(p, 1, to.col, cells, nb_cells);
+            break;
+        default:
+            p += put_cup(p, to.row, to.col);
+            break;
+    }
+    return p - dst;
+}
+
+
+char *cursor_move(t_cursor_pos from, t_cursor_pos to) {
+    if (from.row == 0 || from.col == 0 || to.row == 0 || to.col == 0) return NULL;
+
+    size_t size = put_cursor_move(NULL, from, to, NULL, 0) + 1;
+
+    char *str = malloc(size);
+    if (!str) return NULL;
+
+    put_cursor_move(str, from, to, NULL, 0);
+    str[size - 1] = '\0';
+
+    gc_add(str);
+
+    return str;
+}
+
+
+static const uint8_t CUBE_LEVELS[6] = {0, 95, 135, 175, 215, 255};
+
+
+static int cube_index(uint8_t v) {
+    if (v < 48) return 0;
+    if (v < 115) return 1;
+    return (v - 35) / 40;
+}
+
+
+static int dist2(int r1, int g1, int b1, int r2, int g2, int b2) {
+    return (r1 - r2) * (r1 - r2) + (g1 - g2) * (g1 - g2) + (b1 - b2) * (b1 - b2);
+}
+
+
+uint8_t rgb_to_color8(uint8_t r, uint8_t g, uint8_t b) {
+    int ri = cube_index(r);
+    int gi = cube_index(g);
+    int bi = cube_index(b);
+    int cube_d = dist2(r, g, b, CUBE_LEVELS[ri], CUBE_LEVELS[gi], CUBE_LEVELS[bi]);
+
+    int avg = (r + g + b) / 3;
+    int gray_i = (avg > 238) ? 23 : (avg < 8) ? 0 : (avg - 3) / 10;
+    int gray_v = 8 + gray_i * 10;
+    int gray_d = dist2(r, g, b, gray_v, gray_v, gray_v);
+
+    if (gray_d < cube_d) return (uint8_t)(232 + gray_i);
+    return (uint8_t)(16 + 36 * ri + 6 * gi + bi);
+}
+
+
+/* --- Gradients --- */
+
+#define GRADIENT_CHUNK 64
+#define LINEAR_LUT_SIZE 4096
+
+/* sRGB component -> linear light, scaled to 0..65535 */
+static const uint16_t SRGB_TO_LINEAR[256] = {
+        0,    20,    40,    60,    80,    99,   119,   139,   159,   179,   199,   219,
+      241,   264,   288,   313,   340,   367,   396,   427,   458,   491,   526,   562,
+      599,   637,   677,   718,   761,   805,   851,   898,   947,   997,  1048,  1101,
+     1156,  1212,  1270,  1330,  1391,  1453,  1517,  1583,  1651,  1720,  1790,  1863,
+     1937,  2013,  2090,  2170,  2250,  2333,  2418,  2504,  2592,  2681,  2773,  2866,
+     2961,  3058,  3157,  3258,  3360,  3464,  3570,  3678,  3788,  3900,  4014,  4129,
+     4247,  4366,  4488,  4611,  4736,  4864,  4993,  5124,  5257,  5392,  5530,  5669,
+     5810,  5953,  6099,  6246,  6395,  6547,  6700,  6856,  7014,  7174,  7335,  7500,
+     7666,  7834,  8004,  8177,  8352,  8528,  8708,  8889,  9072,  9258,  9445,  9635,
+     9828, 10022, 10219, 10417, 10619, 10822, 11028, 11235, 11446, 11658, 11873, 12090,
+    12309, 12530, 12754, 12980, 13209, 13440, 13673, 13909, 14146, 14387, 14629, 14874,
+    15122, 15371, 15623, 15878, 16135, 16394, 16656, 16920, 17187, 17456, 17727, 18001,
+    18277, 18556, 18837, 19121, 19407, 19696, 19987, 20281, 20577, 20876, 21177, 21481,
+    21787, 22096, 22407, 22721, 23038, 23357, 23678, 24002, 24329, 24658, 24990, 25325,
+    25662, 26001, 26344, 26688, 27036, 27386, 27739, 28094, 28452, 28813, 29176, 29542,
+    29911, 30282, 30656, 31033, 31412, 31794, 32179, 32567, 32957, 33350, 33745, 34143,
+    34544, 34948, 35355, 35764, 36176, 36591, 37008, 37429, 37852, 38278, 38706, 39138,
+    39572, 40009, 40449, 40891, 41337, 41785, 42236, 42690, 43147, 43606, 44069, 44534,
+    45002, 45473, 45947, 46423, 46903, 47385, 47871, 48359, 48850, 49344, 49841, 50341,
+    50844, 51349, 51858, 52369, 52884, 53401, 53921, 54445, 54971, 55500, 56032, 56567,
+    57105, 57646, 58190, 58737, 59287, 59840, 60396, 60955, 61517, 62082, 62650, 63221,
+    63795, 64372, 64952, 65535
+};
+
+/* linear light (LINEAR_LUT_SIZE steps) -> sRGB component, built from SRGB_TO_LINEAR on first use */
+static uint8_t g_linear_to_srgb[LINEAR_LUT_SIZE];
+static pthread_once_t g_linear_lut_once = PTHREAD_ONCE_INIT;
+
+
+static void build_linear_lut(void) {
+    int s = 0;
+
+    for (int i = 0; i < LINEAR_LUT_SIZE; i++) {
+        uint32_t v = (uint32_t)i * 65535 / (LINEAR_LUT_SIZE - 1);
+        while (s < 255 && (uint32_t)SRGB_TO_LINEAR[s] + SRGB_TO_LINEAR[s + 1] < 2 * v) s++;
+        g_linear_to_srgb[i] = (uint8_t)s;
+    }
+}
+
+
+static float cbrt_approx(float x) {
+    union { float f; uint32_t u; } v = { x };
+
+    if (x <= 0.0f) return 0.0f;
+    v.u = v.u / 3 + 709921077;
+    for (int i = 0; i < 3; i++) {
+        v.f -= (v.f * v.f * v.f - x) / (3.0f * v.f * v.f);
+    }
+    return v.f;
+}
+
+
+/* OKLab components in 16.16 fixed point */
+typedef struct s_lab {
+    int32_t l;
+    int32_t a;
+    int32_t b;
+} t_lab;
+
+
+static t_lab rgb_to_lab(t_rgb c) {
+    float r = SRGB_TO_LINEAR[c.r] / 65535.0f;
+    float g = SRGB_TO_LINEAR[c.g] / 65535.0f;
+    float b = SRGB_TO_LINEAR[c.b] / 65535.0f;
+
+    float l = cbrt_approx(0.4122214708f * r + 0.5363371080f * g + 0.0514459929f * b);
+    float m = cbrt_approx(0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    float s = cbrt_approx(0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    t_lab lab;
+    lab.l = (int32_t)((0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s) * 65536.0f);
+    lab.a = (int32_t)((1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s) * 65536.0f);
+    lab.b = (int32_t)((0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s) * 65536.0f);
+    return lab;
+}
+
+
+static uint8_t linear_to_srgb(float v) {
+    if (v <= 0.0f) return 0;
+    if (v >= 1.0f) return 255;
+    return g_linear_to_srgb[(int)(v * (LINEAR_LUT_SIZE - 1) + 0.5f)];
+}
+
+
+static t_rgb lab_to_rgb(int32_t fl, int32_t fa, int32_t fb) {
+    float L = fl / 65536.0f;
+    float A = fa / 65536.0f;
+    float B = fb / 65536.0f;
+
+    float l = L + 0.3963377774f * A + 0.2158037573f * B;
+    float m = L - 0.1055613458f * A - 0.0638541728f * B;
+    float s = L - 0.0894841775f * A - 1.2914855480f * B;
+    l = l * l * l;
+    m = m * m * m;
+    s = s * s * s;
+
+    t_rgb c;
+    c.r = linear_to_srgb( 4.0767416621f * l - 3.3077115913f * m + 0.2309699292f * s);
+    c.g = linear_to_srgb(-1.2684380046f * l + 2.6097574011f * m - 0.3413193965f * s);
+    c.b = linear_to_srgb(-0.0041960863f * l - 0.7034186147f * m + 1.7076147010f * s);
+    return c;
+}
+
+
+static void lerp_rgb(t_rgb *out, size_t first, size_t end, uint64_t step, t_rgb a, t_rgb b) {
+    int32_t dr = b.r - a.r;
+    int32_t dg = b.g - a.g;
+    int32_t db = b.b - a.b;
+
+    for (size_t i = first; i < end; i++) {
+        int32_t f = (int32_t)(((i * step) >> 16) & 0xFFFF);
+        out[i - first].r = (uint8_t)(a.r + ((dr * f + 0x8000) >> 16));
+        out[i - first].g = (uint8_t)(a.g + ((dg * f + 0x8000) >> 16));
+        out[i - first].b = (uint8_t)(a.b + ((db * f + 0x8000) >> 16));
+    }
+}
+
+
+static void lerp_lab(t_rgb *out, size_t first, size_t end, uint64_t step, t_rgb ca, t_rgb cb) {
+    t_lab a = rgb_to_lab(ca);
+    t_lab b = rgb_to_lab(cb);
+    int64_t dl = b.l - a.l;
+    int64_t da = b.a - a.a;
+    int64_t db = b.b - a.b;
+
+    for (size_t i = first; i < end; i++) {
+        int64_t f = (int64_t)(((i * step) >> 16) & 0xFFFF);
+        out[i - first] = lab_to_rgb(a.l + (int32_t)((dl * f) >> 16),
+                                    a.a + (int32_t)((da * f) >> 16),
+                                    a.b + (int32_t)((db * f) >> 16));
+    }
+}
+
+
+/*
+ * Position i of n is i * step in 32.32 fixed point, step = (nb_stops - 1) / (n - 1):
+ * the integer part selects the segment, the upper 16 fraction bits weight it.
+ * Each segment is processed as one straight loop so the compiler can vectorize it.
+ */
+static void gradient_fill_range(t_rgb *out, size_t first, size_t count, size_t n,
+                                const t_rgb *stops, size_t nb_stops, GradientSpace space) {
+    size_t end = first + count;
+
+    if (nb_stops == 1 || n == 1) {
+        for (size_t i = 0; i < count; i++) out[i] = stops[0];
+        return;
+    }
+    /* Gradients may be rendered from several threads */
+    if (space == GRADIENT_SPACE_OKLAB) pthread_once(&g_linear_lut_once, build_linear_lut);
+
+    uint64_t step = (((uint64_t)(nb_stops - 1)) << 32) / (n - 1);
+    size_t i = first;
+
+    /* The last sample is the last stop: when step is exact its segment would be nb_stops - 1,
+       with no stop after it to interpolate towards */
+    size_t last = (end == n) ? n - 1 : end;
+
+    while (i < last) {
+        size_t seg = (size_t)((i * step) >> 32);
+        if (seg > nb_stops - 2) seg = nb_stops - 2;
+
+        size_t seg_end = (size_t)(((((uint64_t)seg + 1) << 32) + step - 1) / step);
+        if (seg_end > last) seg_end = last;
+
+        if (space == GRADIENT_SPACE_OKLAB) {
+            lerp_lab(out + (i - first), i, seg_end, step, stops[seg], stops[seg + 1]);
+        } else {
+            lerp_rgb(out + (i - first), i, seg_end, step, stops[seg], stops[seg + 1]);
+        }
+        i = seg_end;
+    }
+    if (last < end) out[last - first] = stops[nb_stops - 1];
+}
+
+
+void gradient_fill(t_rgb *out, size_t n, const t_rgb *stops, size_t nb_stops, GradientSpace space) {
+    if (!out || !stops || nb_stops == 0 || n == 0) return;
+
+    gradient_fill_range(out, 0, n, n, stops, nb_stops, space);
+}
+
+
+size_t gradient_size(size_t n, GradientDepth depth, const char *cell) {
+    size_t body = (depth == GRADIENT_DEPTH_8) ? sizeof("[38;5;255m") - 1 : COLOR_SEQ_BODY_MAX;
+    size_t cell_len = (cell) ? strlen(cell) : 0;
+
+    return n * (g_ansi_esc_len + body + cell_len) + 1;
+}
+
+
+size_t gradient_render(char *dst, size_t size, size_t n, const t_rgb *stops, size_t nb_stops,
+                       GradientSpace space, GradientDepth depth, ColorLayer layer, const char *cell) {
+    if (!dst || !stops || nb_stops == 0) return 0;
+    if (size < gradient_size(n, depth, cell)) return 0;
+
+    size_t cell_len = (cell) ? strlen(cell) : 0;
+    t_rgb chunk[GRADIENT_CHUNK];
+    char *p = dst;
+
+    for (size_t first = 0; first < n; first += GRADIENT_CHUNK) {
+        size_t count = (n - first < GRADIENT_CHUNK) ? n - first : GRADIENT_CHUNK;
+        gradient_fill_range(chunk, first, count, n, stops, nb_stops, space);
+
+        for (size_t i = 0; i < count; i++) {
+            if (depth == GRADIENT_DEPTH_8) {
+                p += put_color8(p, layer, rgb_to_color8(chunk[i].r, chunk[i].g, chunk[i].b));
+            } else {
+                p += put_color24(p, layer, chunk[i].r, chunk[i].g, chunk[i].b);
+            }
+            memcpy(p, cell, cell_len);
+            p += cell_len;
+        }
+    }
+    *p = '\0';
+
+    return p - dst;
+}
+
+
+/* Prefix + code, NUL-terminated, length in the last byte (COLOR_LEN()) */
+static void set_entry(char *entry, const char *code) {
+    size_t len = g_ansi_esc_len + strlen(code);
+
+    memcpy(entry, g_ansi_esc_char, g_ansi_esc_len);
+    memcpy(entry + g_ansi_esc_len, code, len - g_ansi_esc_len);
+    memset(entry + len, 0, COLOR_STR_SIZE - len);
+    entry[COLOR_STR_SIZE - 1] = (char)len;
+}
+
+
 void init_fore(void) {
     /* Init Fore */
     for (int i = 0; i < NB_FORE_COLORS; i++) {
-        snprintf(Fore.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_FORE_CODES[i]);
+        set_entry(Fore.array[i], RAW_FORE_CODES[i]);
     }
 }
 
@@ -402,7 +908,7 @@ void init_fore(void) {
 void init_back(void) {
     /* Init Back */
     for (int i = 0; i < NB_BACK_COLORS; i++) {
-        snprintf(Back.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_BACK_CODES[i]);
+        set_entry(Back.array[i], RAW_BACK_CODES[i]);
     }
 }
 
@@ -410,7 +916,7 @@ void init_back(void) {
 void init_style(void) {
     /* Init Style */
     for (int i = 0; i < NB_STYLE; i++) {
-        snprintf(Style.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_STYLE_CODES[i]);
+        set_entry(Style.array[i], RAW_STYLE_CODES[i]);
     }
     
     Style.RESET_ALL = gc_reset;
@@ -420,7 +926,7 @@ void init_style(void) {
 void init_disable(void) {
     /* Init Disable */
     for (int i = 0; i < NB_DISABLE; i++) {
-        snprintf(Disable.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_DISABLE_CODES[i]);
+        set_entry(Disable.array[i], RAW_DISABLE_CODES[i]);
     }
 }
 
@@ -428,7 +934,7 @@ void init_disable(void) {
 void init_default(void) {
     /* Init Default */
     for (int i = 0; i < NB_DEFAULT; i++) {
-        snprintf(Default.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_DEFAULT_CODES[i]);
+        set_entry(Default.array[i], RAW_DEFAULT_CODES[i]);
     }
 }
 
@@ -436,7 +942,7 @@ void init_default(void) {
 void init_font(void) {
     /* Init Font */
     for (int i = 0; i < NB_FONT; i++) {
-        snprintf(Font.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_FONT_CODES[i]);
+        set_entry(Font.array[i], RAW_FONT_CODES[i]);
     }
 }
 
@@ -444,7 +950,7 @@ void init_font(void) {
 void init_misc(void) {
     /* Init Misc */
     for (int i = 0; i < NB_MISC; i++) {
-        snprintf(Misc.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_MISC_CODES[i]);
+        set_entry(Misc.array[i], RAW_MISC_CODES[i]);
     }
 }
 
@@ -452,7 +958,7 @@ void init_misc(void) {
 void init_cursor(void) {
     /* Init Cursor */
     for (int i = 0; i < NB_CURSOR; i++) {
-        snprintf(Cursor.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_CURSOR_CODES[i]);
+        set_entry(Cursor.array[i], RAW_CURSOR_CODES[i]);
     }
 }
 
@@ -460,7 +966,7 @@ void init_cursor(void) {
 void init_screen(void) {
     /* Init Screen */
     for (int i = 0; i < NB_SCREEN; i++) {
-        snprintf(Screen.array[i], COLOR_STR_SIZE, "%s%s", get_ansi_esc_char(), RAW_SCREEN_CODES[i]);
+        set_entry(Screen.array[i], RAW_SCREEN_CODES[i]);
     }
 }
 
@@ -500,8 +1006,29 @@ const InitEntry init_map[] = {
 };
 
 
-void init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_show, const unsigned char o_auto_clean, const unsigned char o_intercept_sig, int o_flags) {
-    g_ansi_esc_char = (o_ansi_esc_char) ? o_ansi_esc_char : "\033";
+#define MAX_INIT_HOOKS 8
+
+static InitFunction g_init_hooks[MAX_INIT_HOOKS];
+static size_t g_nb_init_hooks = 0;
+static unsigned char g_initialized = 0;
+
+
+int color_add_init_hook(void (*hook)(void)) {
+    if (!hook || g_nb_init_hooks >= MAX_INIT_HOOKS) return 0;
+
+    g_init_hooks[g_nb_init_hooks++] = hook;
+    if (g_initialized) hook();
+
+    return 1;
+}
+
+
+int init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_show, const unsigned char o_auto_clean, const unsigned char o_intercept_sig, int o_flags) {
+    /* Longer prefixes would not fit the table entries */
+    int accepted = !o_ansi_esc_char || strlen(o_ansi_esc_char) <= COLOR_ESC_MAX;
+
+    g_ansi_esc_char = (o_ansi_esc_char && accepted) ? o_ansi_esc_char : "\033";
+    g_ansi_esc_len = strlen(g_ansi_esc_char);
     g_cursor_auto_show = o_cursor_auto_show;
     g_auto_clean = o_auto_clean;
 
@@ -511,6 +1038,11 @@ void init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_s
         }
     }
     
+    g_initialized = 1;
+    for (size_t i = 0; i < g_nb_init_hooks; i++) {
+        g_init_hooks[i]();
+    }
+
     if (o_intercept_sig) {
         setup_signals();
     }
@@ -519,6 +1051,8 @@ void init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_s
         atexit(gc_clean_all);
         atexit(auto_clean);
     }
+
+    return accepted;
 }
 
 
@@ -601,32 +1135,29 @@ void color_support_test(void) {
 
     printf("%s--- TrueColor Gradients (RGB) ---\n", Style.RESET);
 
-    printf("Fore : ");
-    int r = 255, g = 0, b = 0;
-    for (g = 0; g <= 255; g += 5) {
-        printf("%s█%s", fore_color24(r, g, b), Style.RESET);
-    }
-    printf("\n");
+    char line[4096];
+    const t_rgb red_yellow[] = {{255, 0, 0}, {255, 255, 0}};
+    const t_rgb cyan_blue[] = {{0, 255, 255}, {0, 0, 255}};
+    const t_rgb blue_magenta[] = {{0, 0, 255}, {255, 0, 255}};
+    const t_rgb green_blue[] = {{0, 255, 0}, {0, 0, 255}};
 
-    printf("Fore : ");
-    r = 0, g = 255, b = 255;
-    for (g = 255; g >= 0; g -= 5) {
-        printf("%s█%s", fore_color24(r, g, b), Style.RESET);
-    }
-    printf("\n");
+    gradient_render(line, sizeof(line), 52, red_yellow, 2, GRADIENT_SPACE_RGB, GRADIENT_DEPTH_24, COLOR_LAYER_FORE, "█");
+    printf("Fore : %s%s\n", line, Style.RESET);
 
-    printf("Back : ");
-    r = 0, g = 0, b = 255;
-    for (r = 0; r <= 255; r += 5) {
-        printf("%s %s", back_color24(r, g, b), Style.RESET);
-    }
-    printf("\n");
+    gradient_render(line, sizeof(line), 52, cyan_blue, 2, GRADIENT_SPACE_RGB, GRADIENT_DEPTH_24, COLOR_LAYER_FORE, "█");
+    printf("Fore : %s%s\n", line, Style.RESET);
 
-    printf("Back : ");
-    for (int i = 0; i <= 255; i += 5) {
-        printf("%s %s", back_color24(0, 255 - i, i), Style.RESET);
-    }
-    printf("\n");
+    gradient_render(line, sizeof(line), 52, blue_magenta, 2, GRADIENT_SPACE_RGB, GRADIENT_DEPTH_24, COLOR_LAYER_BACK, " ");
+    printf("Back : %s%s\n", line, Style.RESET);
+
+    gradient_render(line, sizeof(line), 52, green_blue, 2, GRADIENT_SPACE_RGB, GRADIENT_DEPTH_24, COLOR_LAYER_BACK, " ");
+    printf("Back : %s%s\n", line, Style.RESET);
+
+    gradient_render(line, sizeof(line), 52, green_blue, 2, GRADIENT_SPACE_OKLAB, GRADIENT_DEPTH_24, COLOR_LAYER_BACK, " ");
+    printf("OKLab: %s%s\n", line, Style.RESET);
+
+    gradient_render(line, sizeof(line), 52, green_blue, 2, GRADIENT_SPACE_OKLAB, GRADIENT_DEPTH_8, COLOR_LAYER_BACK, " ");
+    printf("8-Bit: %s%s\n", line, Style.RESET);
 
     printf("\nTest %s%sUnderline 24-Bit%s\n\n", underline_color24(255, 0, 255), Style.UNDERLINE, Style.RESET);
 
@@ -10,6 +10,12 @@
 #ifndef COLOR_LIB_H
 #define COLOR_LIB_H
 
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* --- Type Definitions --- */
 
 #ifndef UINT8_MAX
@@ -66,7 +72,7 @@ void print(char *msg);
  * @brief Gets the current ANSI escape character used.
  * @return The escape string (usually "\033").
  */
-const char *get_ansi_esc_char(void);
+const char *get_ansi_esc_char(void) __attribute__((pure));
 
 /**
  * @brief Checks if the cursor is set to auto-show on exit.
@@ -113,11 +119,21 @@ typedef enum {
  * various escape sequence categories (Fore, Back, Style, Cursor, etc.) or sets up
  * runtime behavior (signal handling, atexit cleanup).
  * @param o_ansi_esc_char The ANSI escape character prefix (e.g., "\\033"). NULL uses the default ("\\033"). Ex :  "\1xb" or "\e"
+ * Prefixes longer than COLOR_ESC_MAX bytes are rejected: the default is used and 0 is returned.
  * @param o_cursor_auto_show If non-zero, the cursor will be automatically shown/hidden by certain functions.
  * @param o_auto_clean If non-zero, the program will clean-up automaticaly after the end of the program
  * @param o_flags Bitwise OR of ColorInitFlags to control which components are initialized or enabled.
+ * @return 1, or 0 if the prefix was rejected (the tables are still initialized, with "\\033").
+ */
+int init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_show, const unsigned char o_auto_clean, const unsigned char o_intercept_sig, int active_flags);
+
+/**
+ * @brief Registers a function run at the end of every init_color() call.
+ * * Lets add-on modules pre-render sequences that depend on the escape prefix or the tables.
+ * If the library is already initialized, the hook also runs immediately.
+ * @return 1 on success, 0 if the hook table is full.
  */
-void init_color(const char *o_ansi_esc_char, const unsigned char o_cursor_auto_show, const unsigned char o_auto_clean, const unsigned char o_intercept_sig, int active_flags);
+int color_add_init_hook(void (*hook)(void));
 
 
 /* --- Dynamic String Generators (Added from .c) --- */
@@ -141,9 +157,236 @@ char *back_color24(uint8_t r, uint8_t g, uint8_t b);
 char *underline_color24(uint8_t r, uint8_t g, uint8_t b);
 
 
+/* --- Buffer Encoders --- */
+/* Allocation-free variants: they write into a caller buffer (no NUL terminator, no GC) */
+
+/**
+ * @brief SGR color parameter selecting which layer a dynamic color applies to.
+ */
+typedef enum {
+    COLOR_LAYER_FORE      = 38,
+    COLOR_LAYER_BACK      = 48,
+    COLOR_LAYER_UNDERLINE = 58
+} ColorLayer;
+
+/** Longest sequence body written by an encoder, escape prefix excluded ("[38;2;255;255;255m"). */
+#define COLOR_SEQ_BODY_MAX 18
+
+/** Room needed for any single encoded sequence with the current escape prefix. */
+#define COLOR_SEQ_MAX (get_ansi_esc_len() + COLOR_SEQ_BODY_MAX)
+
+/**
+ * @brief Gets the length of the current ANSI escape prefix.
+ * @return strlen(get_ansi_esc_char()), cached by init_color().
+ */
+size_t get_ansi_esc_len(void) __attribute__((pure));
+
+/*
+ * Build modes:
+ * - default: put_color8() / put_color24() are regular functions of color_lib.c.
+ * - COLOR_LIB_INLINE: they are defined static inline in every translation unit, so
+ *   calls with literal arguments constant-fold. Set by the single-header build
+ *   (`make single`), can also be defined by hand when linking libcolor.
+ *
+ * The escape prefix is a runtime setting and is always read through get_ansi_esc_char() /
+ * get_ansi_esc_len(). In the single header they are inlined; with libcolor they stay two
+ * calls per sequence (declared pure, so the compiler hoists them out of loops) and only
+ * the parameter digits fold.
+ */
+#if defined(COLOR_LIB_INLINE)
+    #define COLOR_ENCODER static inline
+#else
+    #define COLOR_ENCODER
+#endif
+
+#if defined(COLOR_LIB_INLINE) || defined(COLOR_LIB_ENCODERS)
+
+static inline size_t color_put_u8(char *dst, uint8_t v) {
+    if (v >= 100) {
+        dst[0] = '0' + v / 100;
+        dst[1] = '0' + (v / 10) % 10;
+        dst[2] = '0' + v % 10;
+        return 3;
+    }
+    if (v >= 10) {
+        dst[0] = '0' + v / 10;
+        dst[1] = '0' + v % 10;
+        return 2;
+    }
+    dst[0] = '0' + v;
+    return 1;
+}
+
+static inline char *color_put_layer(char *p, ColorLayer layer, char mode) {
+    const char *esc = get_ansi_esc_char();
+    size_t esc_len = get_ansi_esc_len();
+
+    for (size_t i = 0; i < esc_len; i++) p[i] = esc[i];
+    p += esc_len;
+    p[0] = '[';
+    p[1] = '0' + layer / 10;
+    p[2] = '0' + layer % 10;
+    p[3] = ';';
+    p[4] = mode;
+    p[5] = ';';
+    return p + 6;
+}
+
+/**
+ * @brief Writes an 8-bit (256 colors) sequence, e.g. "\033[38;5;196m".
+ * @param dst Destination, at least COLOR_SEQ_MAX bytes.
+ * @return Number of bytes written.
+ */
+COLOR_ENCODER size_t put_color8(char *dst, ColorLayer layer, uint8_t color) {
+    char *p = color_put_layer(dst, layer, '5');
+
+    p += color_put_u8(p, color);
+    *p++ = 'm';
+
+    return p - dst;
+}
+
+/**
+ * @brief Writes a TrueColor sequence, e.g. "\033[48;2;255;128;0m".
+ * @param dst Destination, at least COLOR_SEQ_MAX bytes.
+ * @return Number of bytes written.
+ */
+COLOR_ENCODER size_t put_color24(char *dst, ColorLayer layer, uint8_t r, uint8_t g, uint8_t b) {
+    char *p = color_put_layer(dst, layer, '2');
+
+    p += color_put_u8(p, r);
+    *p++ = ';';
+    p += color_put_u8(p, g);
+    *p++ = ';';
+    p += color_put_u8(p, b);
+    *p++ = 'm';
+
+    return p - dst;
+}
+
+#else
+
+size_t put_color8(char *dst, ColorLayer layer, uint8_t color);
+size_t put_color24(char *dst, ColorLayer layer, uint8_t r, uint8_t g, uint8_t b);
+
+#endif
+
+/*
+ * Buffer versions of the remaining generators, same output as custom_code() and
+ * cursor_cup() / cursor_cuu() ... : dst needs COLOR_SEQ_MAX bytes, the return value is
+ * the length (0 where the generator returns NULL).
+ */
+size_t put_custom_code(char *dst, unsigned char code);
+size_t put_cursor_cup(char *dst, uint16_t row, uint16_t column);
+size_t put_cursor_cuu(char *dst, uint16_t n);
+size_t put_cursor_cud(char *dst, uint16_t n);
+size_t put_cursor_cuf(char *dst, uint16_t n);
+size_t put_cursor_cub(char *dst, uint16_t n);
+
+/**
+ * @brief Finds the closest entry of the xterm 256-color palette (6x6x6 cube or gray ramp).
+ * @return Palette index in 16..255.
+ */
+uint8_t rgb_to_color8(uint8_t r, uint8_t g, uint8_t b);
+
+
+/* --- Cursor Motion Planner --- */
+
+/**
+ * @brief 1-based cursor position (row 1, column 1 is the top-left cell).
+ */
+typedef struct s_cursor_pos {
+    uint16_t row;
+    uint16_t col;
+} t_cursor_pos;
+
+/**
+ * @brief Writes the shortest byte sequence moving the cursor from 'from' to 'to'.
+ * * Candidates are CUP, CUU/CUD/VPA combined with CUF/CUB/CHA, carriage return,
+ * line feeds (always followed by a CR, so ONLCR does not matter), backspaces and,
+ * when 'cells' is given, reprinting the known cells between both columns. On equal
+ * cost CUP and CHA are kept over the relative forms.
+ * * 'from' must not be in the pending-wrap state, i.e. right after a glyph was printed
+ * in the last column: terminals disagree on where relative moves and backspaces land
+ * from there. Emit a CR or an absolute move (put_cursor_cup()) first.
+ * @param dst Destination, at least COLOR_SEQ_MAX bytes (plus the reprinted cells), or NULL to get the cost only.
+ * @param cells Known single-byte content of the destination row from column 1, printable with the current pen, or NULL.
+ * @param nb_cells Number of known cells.
+ * @return Number of bytes written (or needed), 0 if a position is 0 or the cursor does not move.
+ */
+size_t put_cursor_move(char *dst, t_cursor_pos from, t_cursor_pos to, const char *cells, size_t nb_cells);
+
+/**
+ * @brief GC-managed version of put_cursor_move() without known cells.
+ * @return The motion string ("" when both positions are equal), or NULL on invalid position or allocation failure.
+ */
+char *cursor_move(t_cursor_pos from, t_cursor_pos to);
+
+
+/* --- Gradients --- */
+
+/**
+ * @brief RGB color stop.
+ */
+typedef struct s_rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} t_rgb;
+
+/**
+ * @brief Color space the stops are interpolated in.
+ */
+typedef enum {
+    GRADIENT_SPACE_RGB   = 0, ///< Straight sRGB, fastest
+    GRADIENT_SPACE_OKLAB = 1  ///< Perceptual (OKLab), no muddy midpoints
+} GradientSpace;
+
+/**
+ * @brief Output color depth of a rendered gradient.
+ */
+typedef enum {
+    GRADIENT_DEPTH_8  = 8,  ///< Nearest 256-color palette entry
+    GRADIENT_DEPTH_24 = 24  ///< TrueColor
+} GradientDepth;
+
+/**
+ * @brief Interpolates n evenly spaced colors across two or more stops.
+ * * Uses 16.16 fixed-point arithmetic. The first and last colors are exactly the first and last
+ * stops; in RGB the intermediate stops are hit when they fall on a sample, in OKLab the colors
+ * between the ends go through a linear-light table and may differ from a stop by 1 per component.
+ * @param out Destination array of n colors.
+ * @param nb_stops Number of stops (1 gives a flat fill).
+ */
+void gradient_fill(t_rgb *out, size_t n, const t_rgb *stops, size_t nb_stops, GradientSpace space);
+
+/**
+ * @brief Computes the buffer size gradient_render() needs, NUL terminator included.
+ * @param cell Text printed after each sequence (e.g. "█"), or NULL.
+ */
+size_t gradient_size(size_t n, GradientDepth depth, const char *cell);
+
+/**
+ * @brief Renders n color sequences (each followed by 'cell') into a contiguous buffer.
+ * * Does not allocate; the result is NUL-terminated and can be printed in one call.
+ * @param dst Destination buffer.
+ * @param size Size of dst, see gradient_size().
+ * @return Number of bytes written (NUL excluded), or 0 if dst is too small or the stops are invalid.
+ */
+size_t gradient_render(char *dst, size_t size, size_t n, const t_rgb *stops, size_t nb_stops,
+                       GradientSpace space, GradientDepth depth, ColorLayer layer, const char *cell);
+
+
 /* --- Constants & Structures --- */
 
-#define COLOR_STR_SIZE 8
+/** Longest escape prefix init_color() accepts (e.g. "\\033", "\\u001b"). */
+#define COLOR_ESC_MAX 8
+
+/**
+ * Size of a table entry: the escape prefix, the longest code ("[100m", "[?25l"), the NUL
+ * terminator, then the sequence length in the last byte (see COLOR_LEN()).
+ */
+#define COLOR_STR_SIZE 16
 
 #define NB_FORE_COLORS 16
 #define NB_BACK_COLORS 16
@@ -366,6 +609,27 @@ extern t_misc Misc;
 extern t_cursor Cursor;
 extern t_screen Screen;
 
+/**
+ * @brief Length of a table entry without strlen, e.g. COLOR_LEN(Fore.RED) or COLOR_LEN(Back.array[i]).
+ */
+#define COLOR_LEN(entry) ((size_t)(unsigned char)(entry)[COLOR_STR_SIZE - 1])
+
+/**
+ * @brief Sequence descriptor, ready for memcpy() or an iovec.
+ */
+typedef struct s_color_seq {
+    const char *ptr;
+    uint8_t len;
+} t_color_seq;
+
+/**
+ * @brief Builds the descriptor of a table entry, e.g. color_seq(Style.RESET).
+ */
+static inline t_color_seq color_seq(const char *entry) {
+    t_color_seq seq = {entry, (uint8_t)entry[COLOR_STR_SIZE - 1]};
+    return seq;
+}
+
 /**
  * @brief Runs a full demonstration of the library's capabilities.
  * Prints all colors, styles, and animations to stdout.
@@ -373,4 +637,8 @@ extern t_screen Screen;
 void color_support_test(void);
 
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* COLOR_LIB_H */
\ No newline at end of file
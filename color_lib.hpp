@@ -0,0 +1,215 @@
+/**
+ * @file color_lib.hpp
+ * @brief C++17 front-end: escape sequences built at compile time, GC-free runtime writers.
+ *
+ * Compile-time sequences are constexpr character arrays using the default "\033" prefix,
+ * byte for byte equal to what Fore/Back/Style, custom_code(), fore_color8() and
+ * fore_color24() produce:
+ *
+ *     constexpr auto warn = color::style::bold + color::fg<255, 128, 0>;
+ *     std::printf("%sdisk almost full%s\n", warn.c_str(), color::style::reset.c_str());
+ *
+ * Runtime colors go through the allocation-free C encoders (put_color8 / put_color24)
+ * into a std::string or a std::span<char> (C++20), and use the prefix given to init_color().
+ */
+
+#ifndef COLOR_LIB_HPP
+#define COLOR_LIB_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+#include "color_lib.h"
+
+namespace color {
+
+/**
+ * @brief NUL-terminated escape sequence of N bytes, usable in constant expressions.
+ */
+template <std::size_t N>
+struct sequence {
+    char data[N + 1] {};
+
+    static constexpr std::size_t size() { return N; }
+    constexpr const char *c_str() const { return data; }
+    constexpr std::string_view view() const { return std::string_view(data, N); }
+    constexpr operator std::string_view() const { return view(); }
+};
+
+/**
+ * @brief Concatenates two sequences at compile time (composed styles).
+ */
+template <std::size_t N, std::size_t M>
+constexpr sequence<N + M> operator+(const sequence<N> &a, const sequence<M> &b) {
+    sequence<N + M> s {};
+    for (std::size_t i = 0; i < N; i++) s.data[i] = a.data[i];
+    for (std::size_t i = 0; i < M; i++) s.data[N + i] = b.data[i];
+    return s;
+}
+
+namespace detail {
+
+constexpr std::size_t digits(unsigned v) {
+    return (v >= 100) ? 3 : (v >= 10) ? 2 : 1;
+}
+
+template <unsigned... Params>
+constexpr std::size_t params_len() {
+    if constexpr (sizeof...(Params) == 0) {
+        return 0;
+    } else {
+        return ((digits(Params) + 1) + ...) - 1;
+    }
+}
+
+/* ESC [ p1 ; p2 ; ... m */
+template <unsigned... Params>
+constexpr sequence<3 + params_len<Params...>()> sgr() {
+    constexpr unsigned values[sizeof...(Params) + 1] = {Params...};
+    sequence<3 + params_len<Params...>()> s {};
+    std::size_t i = 0;
+
+    s.data[i++] = '\033';
+    s.data[i++] = '[';
+    for (std::size_t k = 0; k < sizeof...(Params); k++) {
+        unsigned v = values[k];
+        if (k > 0) s.data[i++] = ';';
+        if (v >= 100) s.data[i++] = static_cast<char>('0' + v / 100);
+        if (v >= 10) s.data[i++] = static_cast<char>('0' + (v / 10) % 10);
+        s.data[i++] = static_cast<char>('0' + v % 10);
+    }
+    s.data[i] = 'm';
+    return s;
+}
+
+} // namespace detail
+
+/**
+ * Any SGR sequence, e.g. sgr<1, 4> == "\033[1;4m" (custom_code() for a single code).
+ * sgr<> is "\033[m", which terminals treat as a reset.
+ */
+template <unsigned... Params>
+inline constexpr auto sgr = detail::sgr<Params...>();
+
+/* --- TrueColor (RGB 24-bit) --- */
+template <std::uint8_t R, std::uint8_t G, std::uint8_t B>
+inline constexpr auto fg = detail::sgr<38, 2, R, G, B>();
+template <std::uint8_t R, std::uint8_t G, std::uint8_t B>
+inline constexpr auto bg = detail::sgr<48, 2, R, G, B>();
+template <std::uint8_t R, std::uint8_t G, std::uint8_t B>
+inline constexpr auto ul = detail::sgr<58, 2, R, G, B>();
+
+/* --- 8-bit Colors (256 colors) --- */
+template <std::uint8_t C>
+inline constexpr auto fg8 = detail::sgr<38, 5, C>();
+template <std::uint8_t C>
+inline constexpr auto bg8 = detail::sgr<48, 5, C>();
+template <std::uint8_t C>
+inline constexpr auto ul8 = detail::sgr<58, 5, C>();
+
+/** Same codes as the Fore table. */
+namespace fore {
+inline constexpr auto black          = sgr<30>;
+inline constexpr auto red            = sgr<31>;
+inline constexpr auto green          = sgr<32>;
+inline constexpr auto yellow         = sgr<33>;
+inline constexpr auto blue           = sgr<34>;
+inline constexpr auto magenta        = sgr<35>;
+inline constexpr auto cyan           = sgr<36>;
+inline constexpr auto white          = sgr<37>;
+inline constexpr auto bright_black   = sgr<90>;
+inline constexpr auto bright_red     = sgr<91>;
+inline constexpr auto bright_green   = sgr<92>;
+inline constexpr auto bright_yellow  = sgr<93>;
+inline constexpr auto bright_blue    = sgr<94>;
+inline constexpr auto bright_magenta = sgr<95>;
+inline constexpr auto bright_cyan    = sgr<96>;
+inline constexpr auto bright_white   = sgr<97>;
+} // namespace fore
+
+/** Same codes as the Back table. */
+namespace back {
+inline constexpr auto black          = sgr<40>;
+inline constexpr auto red            = sgr<41>;
+inline constexpr auto green          = sgr<42>;
+inline constexpr auto yellow         = sgr<43>;
+inline constexpr auto blue           = sgr<44>;
+inline constexpr auto magenta        = sgr<45>;
+inline constexpr auto cyan           = sgr<46>;
+inline constexpr auto white          = sgr<47>;
+inline constexpr auto bright_black   = sgr<100>;
+inline constexpr auto bright_red     = sgr<101>;
+inline constexpr auto bright_green   = sgr<102>;
+inline constexpr auto bright_yellow  = sgr<103>;
+inline constexpr auto bright_blue    = sgr<104>;
+inline constexpr auto bright_magenta = sgr<105>;
+inline constexpr auto bright_cyan    = sgr<106>;
+inline constexpr auto bright_white   = sgr<107>;
+} // namespace back
+
+/** Same codes as the Style table. */
+namespace style {
+inline constexpr auto reset            = sgr<0>;
+inline constexpr auto bold             = sgr<1>;
+inline constexpr auto dim              = sgr<2>;
+inline constexpr auto italic           = sgr<3>;
+inline constexpr auto underline        = sgr<4>;
+inline constexpr auto blink            = sgr<5>;
+inline constexpr auto blink_speed      = sgr<6>;
+inline constexpr auto reverse          = sgr<7>;
+inline constexpr auto hidden           = sgr<8>;
+inline constexpr auto strikethrough    = sgr<9>;
+inline constexpr auto underline_double = sgr<21>;
+} // namespace style
+
+/* Payload checks against the C encoders' format */
+static_assert(fg<255, 128, 0>.view() == "\033[38;2;255;128;0m");
+static_assert(bg8<236>.view() == "\033[48;5;236m");
+static_assert(ul8<7>.view() == "\033[58;5;7m");
+static_assert((style::bold + fore::bright_red).view() == "\033[1m\033[91m");
+static_assert(sgr<>.view() == "\033[m");
+
+/* --- Runtime writers (no GC, use the init_color() prefix) --- */
+
+/** Appends a TrueColor sequence to 'out'. */
+inline void append_rgb(std::string &out, ColorLayer layer, std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+    std::size_t old = out.size();
+    out.resize(old + COLOR_SEQ_MAX);
+    out.resize(old + put_color24(&out[old], layer, r, g, b));
+}
+
+/** Appends an 8-bit color sequence to 'out'. */
+inline void append_8(std::string &out, ColorLayer layer, std::uint8_t c) {
+    std::size_t old = out.size();
+    out.resize(old + COLOR_SEQ_MAX);
+    out.resize(old + put_color8(&out[old], layer, c));
+}
+
+#if __cplusplus >= 202002L
+/**
+ * @brief Writes a TrueColor sequence at the start of 'dst'.
+ * @return Number of bytes written, 0 if dst is smaller than COLOR_SEQ_MAX.
+ */
+inline std::size_t write_rgb(std::span<char> dst, ColorLayer layer, std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+    if (dst.size() < COLOR_SEQ_MAX) return 0;
+    return put_color24(dst.data(), layer, r, g, b);
+}
+
+/**
+ * @brief Writes an 8-bit color sequence at the start of 'dst'.
+ * @return Number of bytes written, 0 if dst is smaller than COLOR_SEQ_MAX.
+ */
+inline std::size_t write_8(std::span<char> dst, ColorLayer layer, std::uint8_t c) {
+    if (dst.size() < COLOR_SEQ_MAX) return 0;
+    return put_color8(dst.data(), layer, c);
+}
+#endif
+
+} // namespace color
+
+#endif /* COLOR_LIB_HPP */
@@ -0,0 +1,203 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_log.h"
+#include "color_stats.h"
+
+
+#define LOG_PREFIX_SIZE 64
+
+
+typedef struct s_log_prefix {
+    char text[LOG_PREFIX_SIZE];
+    size_t len;
+} t_log_prefix;
+
+
+/* Per-thread timestamp cache: the date part is formatted once per second */
+typedef struct s_log_clock {
+    time_t sec;
+    char text[32];
+    size_t len;
+} t_log_clock;
+
+
+static const char *LEVEL_LABELS[NB_LOG_LEVELS] = {
+    "[TRACE]",
+    "[DEBUG]",
+    "[INFO] ",
+    "[WARN] ",
+    "[ERROR]",
+    "[FATAL]"
+};
+
+
+static t_log_prefix g_log_colored[NB_LOG_LEVELS];
+static t_log_prefix g_log_plain[NB_LOG_LEVELS];
+
+static LogLevel g_log_level = LOG_LEVEL_INFO;
+static int g_log_fd = STDERR_FILENO;
+static LogTimeFormat g_log_time = LOG_TIME_MILLIS;
+static unsigned char g_log_color = 1;
+static unsigned char g_log_color_set = 0;  /* log_set_color() overrides the isatty() default */
+
+static _Thread_local t_log_clock tl_log_clock = {(time_t)-1, {0}, 0};
+static _Thread_local char tl_log_line[LOG_LINE_MAX];
+
+
+/* bold: 1 or 0 (none), color: SGR code; built with the encoders, the tables may not be initialized */
+static void set_prefix(t_log_prefix *prefix, unsigned char bold, unsigned char color, const char *label) {
+    char *p = prefix->text;
+    size_t label_len = strlen(label);
+
+    if (bold) p += put_custom_code(p, bold);
+    p += put_custom_code(p, color);
+    memcpy(p, label, label_len);
+    p += label_len;
+    p += put_custom_code(p, 0);
+    *p++ = ' ';
+    *p = '\0';
+    prefix->len = (size_t)(p - prefix->text);
+}
+
+
+/* Init hook: the escape prefix is final once init_color() ran */
+static void render_prefixes(void) {
+    /* Bright black, cyan, green, yellow, bright red, red background */
+    static const unsigned char colors[NB_LOG_LEVELS] = {90, 36, 32, 33, 91, 41};
+
+    for (int i = 0; i < NB_LOG_LEVELS; i++) {
+        set_prefix(&g_log_colored[i], (i >= LOG_LEVEL_ERROR) ? 1 : 0, colors[i], LEVEL_LABELS[i]);
+
+        int len = snprintf(g_log_plain[i].text, LOG_PREFIX_SIZE, "%s ", LEVEL_LABELS[i]);
+        g_log_plain[i].len = (size_t)len;
+    }
+}
+
+
+static void __attribute__((constructor)) log_auto_init(void) {
+    color_add_init_hook(render_prefixes);
+    g_log_color = (unsigned char)isatty(g_log_fd);
+}
+
+
+void log_set_level(LogLevel level) {
+    g_log_level = level;
+}
+
+
+void log_set_fd(int fd) {
+    g_log_fd = fd;
+    if (!g_log_color_set) g_log_color = (unsigned char)isatty(fd);
+}
+
+
+void log_set_time_format(LogTimeFormat format) {
+    g_log_time = format;
+}
+
+
+void log_set_color(unsigned char enabled) {
+    g_log_color = enabled;
+    g_log_color_set = 1;
+}
+
+
+int log_enabled(LogLevel level) {
+    return level >= g_log_level && level < LOG_LEVEL_OFF;
+}
+
+
+static size_t put_timestamp(char *dst) {
+    struct timespec ts;
+    t_log_clock *cache = &tl_log_clock;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (ts.tv_sec != cache->sec) {
+        struct tm tm;
+        localtime_r(&ts.tv_sec, &tm);
+        cache->len = strftime(cache->text, sizeof(cache->text), "%Y-%m-%d %H:%M:%S", &tm);
+        cache->sec = ts.tv_sec;
+    }
+
+    char *p = dst;
+    memcpy(p, cache->text, cache->len);
+    p += cache->len;
+
+    if (g_log_time == LOG_TIME_MILLIS) {
+        long ms = ts.tv_nsec / 1000000;
+        p[0] = '.';
+        p[1] = '0' + ms / 100;
+        p[2] = '0' + (ms / 10) % 10;
+        p[3] = '0' + ms % 10;
+        p += 4;
+    }
+    *p++ = ' ';
+
+    return p - dst;
+}
+
+
+static int write_all(int fd, const char *buf, size_t len) {
+    size_t done = 0;
+    size_t syscalls = 0;
+
+    while (done < len) {
+        ssize_t n = write(fd, buf + done, len - done);
+        syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            color_stats_flush(syscalls);
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    color_stats_flush(syscalls);
+    return (int)done;
+}
+
+
+int log_vwrite(LogLevel level, const char *format, va_list args) {
+    if (!log_enabled(level) || !format) return 0;
+
+    char *line = tl_log_line;
+    size_t len = 0;
+    const t_log_prefix *prefix = (g_log_color) ? &g_log_colored[level] : &g_log_plain[level];
+
+    if (g_log_time != LOG_TIME_NONE) len += put_timestamp(line);
+
+    memcpy(line + len, prefix->text, prefix->len);
+    len += prefix->len;
+
+    /* Keep room for the newline */
+    size_t room = LOG_LINE_MAX - len - 1;
+    int n = vsnprintf(line + len, room, format, args);
+    if (n < 0) n = 0;
+    if ((size_t)n >= room) {
+        n = (int)room - 1;
+        memcpy(line + len + n - 3, "...", 3);
+    }
+    len += (size_t)n;
+    line[len++] = '\n';
+
+    color_stats_scan(line, len);
+    return write_all(g_log_fd, line, len);
+}
+
+
+int log_write(LogLevel level, const char *format, ...) {
+    if (!log_enabled(level)) return 0;
+
+    va_list args;
+    va_start(args, format);
+    int ret = log_vwrite(level, format, args);
+    va_end(args);
+
+    return ret;
+}
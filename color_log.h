@@ -0,0 +1,97 @@
+/**
+ * @file color_log.h
+ * @brief Colored logger: pre-rendered level prefixes, cached timestamps, one write() per line.
+ *
+ * Level prefixes (color + label + reset) are rendered at init_color() time. The timestamp
+ * text is cached per thread and re-formatted only when the second changes. Each line is
+ * assembled in a per-thread buffer and emitted with a single write(), so lines from
+ * different threads never interleave.
+ */
+
+#ifndef COLOR_LOG_H
+#define COLOR_LOG_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Severity levels, in increasing order.
+ */
+typedef enum {
+    LOG_LEVEL_TRACE = 0,
+    LOG_LEVEL_DEBUG = 1,
+    LOG_LEVEL_INFO  = 2,
+    LOG_LEVEL_WARN  = 3,
+    LOG_LEVEL_ERROR = 4,
+    LOG_LEVEL_FATAL = 5,
+    LOG_LEVEL_OFF   = 6
+} LogLevel;
+
+#define NB_LOG_LEVELS 6
+
+/**
+ * @brief Timestamp printed at the start of each line.
+ */
+typedef enum {
+    LOG_TIME_NONE    = 0, ///< No timestamp
+    LOG_TIME_SECONDS = 1, ///< "2026-10-18 14:03:27"
+    LOG_TIME_MILLIS  = 2  ///< "2026-10-18 14:03:27.042"
+} LogTimeFormat;
+
+/** Longest line, longer messages are cut and end with "..." */
+#define LOG_LINE_MAX 4096
+
+/**
+ * @brief Sets the minimum level written (default LOG_LEVEL_INFO).
+ */
+void log_set_level(LogLevel level);
+
+/**
+ * @brief Sets the output file descriptor (default STDERR_FILENO).
+ *
+ * Colors follow isatty(fd) unless log_set_color() was called.
+ */
+void log_set_fd(int fd);
+
+/**
+ * @brief Sets the timestamp format (default LOG_TIME_MILLIS).
+ */
+void log_set_time_format(LogTimeFormat format);
+
+/**
+ * @brief Enables or disables colored prefixes (default: enabled when the fd is a terminal).
+ */
+void log_set_color(unsigned char enabled);
+
+/**
+ * @brief Checks whether a level would be written.
+ */
+int log_enabled(LogLevel level);
+
+/**
+ * @brief Formats and writes one line: timestamp, level prefix, message, newline.
+ * @return Number of bytes written, 0 if filtered out, -1 on write error.
+ */
+int log_write(LogLevel level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief va_list version of log_write().
+ */
+int log_vwrite(LogLevel level, const char *format, va_list args);
+
+#define LOG_TRACE(...) log_write(LOG_LEVEL_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) log_write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_FATAL(...) log_write(LOG_LEVEL_FATAL, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_LOG_H */
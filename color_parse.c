@@ -0,0 +1,400 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_parse.h"
+
+
+#define COLOR_NAME_MAX 24
+
+
+typedef struct s_named_color {
+    const char *name;
+    uint32_t rgb;
+} t_named_color;
+
+
+/* Generated by tools/gen_color_names.py (make names), do not edit: minimal perfect hash over CSS and X11 names */
+#define NB_COLOR_NAMES 152
+#define NB_NAME_BUCKETS 77
+
+/* Indexed by slot: name, 0xRRGGBB */
+static const t_named_color COLOR_NAMES[NB_COLOR_NAMES] = {
+    {"greenyellow", 0xADFF2F},
+    {"lightgreen", 0x90EE90},
+    {"chartreuse", 0x7FFF00},
+    {"magenta", 0xFF00FF},
+    {"burlywood", 0xDEB887},
+    {"papayawhip", 0xFFEFD5},
+    {"cyan", 0x00FFFF},
+    {"darkgoldenrod", 0xB8860B},
+    {"moccasin", 0xFFE4B5},
+    {"mediumvioletred", 0xC71585},
+    {"olive", 0x808000},
+    {"purple", 0x800080},
+    {"tomato", 0xFF6347},
+    {"chocolate", 0xD2691E},
+    {"peachpuff", 0xFFDAB9},
+    {"orange", 0xFFA500},
+    {"antiquewhite", 0xFAEBD7},
+    {"sienna", 0xA0522D},
+    {"seashell", 0xFFF5EE},
+    {"darkolivegreen", 0x556B2F},
+    {"lightslategrey", 0x778899},
+    {"palevioletred", 0xDB7093},
+    {"mediumspringgreen", 0x00FA9A},
+    {"forestgreen", 0x228B22},
+    {"cornflowerblue", 0x6495ED},
+    {"lime", 0x00FF00},
+    {"mediumslateblue", 0x7B68EE},
+    {"violetred", 0xD02090},
+    {"lightslateblue", 0x8470FF},
+    {"darkgrey", 0xA9A9A9},
+    {"slategray", 0x708090},
+    {"wheat", 0xF5DEB3},
+    {"powderblue", 0xB0E0E6},
+    {"navajowhite", 0xFFDEAD},
+    {"maroon", 0x800000},
+    {"turquoise", 0x40E0D0},
+    {"lightskyblue", 0x87CEFA},
+    {"darkorange", 0xFF8C00},
+    {"lightgray", 0xD3D3D3},
+    {"navy", 0x000080},
+    {"darkorchid", 0x9932CC},
+    {"lightgrey", 0xD3D3D3},
+    {"dodgerblue", 0x1E90FF},
+    {"blanchedalmond", 0xFFEBCD},
+    {"dimgray", 0x696969},
+    {"mintcream", 0xF5FFFA},
+    {"mediumturquoise", 0x48D1CC},
+    {"seagreen", 0x2E8B57},
+    {"royalblue", 0x4169E1},
+    {"orchid", 0xDA70D6},
+    {"lightcyan", 0xE0FFFF},
+    {"darkturquoise", 0x00CED1},
+    {"fuchsia", 0xFF00FF},
+    {"palegreen", 0x98FB98},
+    {"silver", 0xC0C0C0},
+    {"beige", 0xF5F5DC},
+    {"whitesmoke", 0xF5F5F5},
+    {"lightyellow", 0xFFFFE0},
+    {"mediumaquamarine", 0x66CDAA},
+    {"darkviolet", 0x9400D3},
+    {"mediumorchid", 0xBA55D3},
+    {"orangered", 0xFF4500},
+    {"skyblue", 0x87CEEB},
+    {"honeydew", 0xF0FFF0},
+    {"lavenderblush", 0xFFF0F5},
+    {"lightgoldenrod", 0xEEDD82},
+    {"mediumblue", 0x0000CD},
+    {"lavender", 0xE6E6FA},
+    {"darkmagenta", 0x8B008B},
+    {"yellowgreen", 0x9ACD32},
+    {"firebrick", 0xB22222},
+    {"indianred", 0xCD5C5C},
+    {"brown", 0xA52A2A},
+    {"cornsilk", 0xFFF8DC},
+    {"peru", 0xCD853F},
+    {"navyblue", 0x000080},
+    {"tan", 0xD2B48C},
+    {"green", 0x008000},
+    {"floralwhite", 0xFFFAF0},
+    {"lightblue", 0xADD8E6},
+    {"mediumseagreen", 0x3CB371},
+    {"steelblue", 0x4682B4},
+    {"darkslateblue", 0x483D8B},
+    {"springgreen", 0x00FF7F},
+    {"lightseagreen", 0x20B2AA},
+    {"saddlebrown", 0x8B4513},
+    {"rosybrown", 0xBC8F8F},
+    {"gainsboro", 0xDCDCDC},
+    {"thistle", 0xD8BFD8},
+    {"coral", 0xFF7F50},
+    {"darkred", 0x8B0000},
+    {"darksalmon", 0xE9967A},
+    {"dimgrey", 0x696969},
+    {"grey", 0x808080},
+    {"lightsalmon", 0xFFA07A},
+    {"indigo", 0x4B0082},
+    {"palegoldenrod", 0xEEE8AA},
+    {"darkslategray", 0x2F4F4F},
+    {"deepskyblue", 0x00BFFF},
+    {"deeppink", 0xFF1493},
+    {"darkgreen", 0x006400},
+    {"cadetblue", 0x5F9EA0},
+    {"ivory", 0xFFFFF0},
+    {"plum", 0xDDA0DD},
+    {"slateblue", 0x6A5ACD},
+    {"ghostwhite", 0xF8F8FF},
+    {"red", 0xFF0000},
+    {"lightsteelblue", 0xB0C4DE},
+    {"teal", 0x008080},
+    {"darkcyan", 0x008B8B},
+    {"salmon", 0xFA8072},
+    {"khaki", 0xF0E68C},
+    {"mistyrose", 0xFFE4E1},
+    {"white", 0xFFFFFF},
+    {"pink", 0xFFC0CB},
+    {"limegreen", 0x32CD32},
+    {"rebeccapurple", 0x663399},
+    {"azure", 0xF0FFFF},
+    {"bisque", 0xFFE4C4},
+    {"slategrey", 0x708090},
+    {"paleturquoise", 0xAFEEEE},
+    {"oldlace", 0xFDF5E6},
+    {"darkblue", 0x00008B},
+    {"lightgoldenrodyellow", 0xFAFAD2},
+    {"hotpink", 0xFF69B4},
+    {"darkgray", 0xA9A9A9},
+    {"blueviolet", 0x8A2BE2},
+    {"sandybrown", 0xF4A460},
+    {"aliceblue", 0xF0F8FF},
+    {"gray", 0x808080},
+    {"lightslategray", 0x778899},
+    {"aquamarine", 0x7FFFD4},
+    {"olivedrab", 0x6B8E23},
+    {"aqua", 0x00FFFF},
+    {"snow", 0xFFFAFA},
+    {"midnightblue", 0x191970},
+    {"darkslategrey", 0x2F4F4F},
+    {"lightcoral", 0xF08080},
+    {"lawngreen", 0x7CFC00},
+    {"gold", 0xFFD700},
+    {"violet", 0xEE82EE},
+    {"yellow", 0xFFFF00},
+    {"crimson", 0xDC143C},
+    {"darkkhaki", 0xBDB76B},
+    {"linen", 0xFAF0E6},
+    {"blue", 0x0000FF},
+    {"lemonchiffon", 0xFFFACD},
+    {"lightpink", 0xFFB6C1},
+    {"mediumpurple", 0x9370DB},
+    {"goldenrod", 0xDAA520},
+    {"darkseagreen", 0x8FBC8F},
+    {"black", 0x000000},
+};
+
+/* Bucket -> FNV seed of its slot hash, or -(slot + 1) for single-key buckets */
+static const int16_t NAME_DISPLACEMENTS[NB_NAME_BUCKETS] = {
+    -138,    4, -136,    3,    1,    0,    2,    0,    1, -126, -124,    0,
+       2,    0,   16,   27,    0,    7,    2,    5,    1, -121, -112,    3,
+    -101,  -95,    2,    1,  -85,  -78,    0,    1,    1,   13,    1,  -66,
+      28,    1,   12,  -51,   20,   20,   23,  -45,    1,  -24,    2,    0,
+      10,    1,    0,    1,    1,    2,    7,   12,    6,  -18,    3,    1,
+       8,    0,    5,  -12,    1,   30,  197,   13,    9,    2,  134,    0,
+       4,   19,  143,   23,   12,
+};
+
+
+/* Hex digit value + 1, 0 for anything else */
+static const uint8_t HEX_DIGITS[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16
+};
+
+
+static uint32_t fnv1a(const char *s, size_t len, uint32_t seed) {
+    uint32_t h = (seed) ? seed : 0x811C9DC5u;
+
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)s[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+
+static t_rgb rgb_from_u32(uint32_t v) {
+    t_rgb c;
+
+    c.r = (uint8_t)(v >> 16);
+    c.g = (uint8_t)(v >> 8);
+    c.b = (uint8_t)v;
+    return c;
+}
+
+
+int color_lookup_name(const char *name, size_t len, t_rgb *out) {
+    char key[COLOR_NAME_MAX];
+    size_t n = 0;
+
+    if (!name) return 0;
+
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (c == ' ' || c == '-' || c == '_') continue;
+        if (n >= COLOR_NAME_MAX) return 0;
+        key[n++] = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    }
+    if (n == 0) return 0;
+
+    int d = NAME_DISPLACEMENTS[fnv1a(key, n, 0) % NB_NAME_BUCKETS];
+    size_t slot = (d < 0) ? (size_t)(-d - 1) : fnv1a(key, n, (uint32_t)d) % NB_COLOR_NAMES;
+    const t_named_color *entry = &COLOR_NAMES[slot];
+
+    if (strncmp(entry->name, key, n) != 0 || entry->name[n] != '\0') return 0;
+
+    if (out) *out = rgb_from_u32(entry->rgb);
+    return 1;
+}
+
+
+/* "#RGB" / "#RRGGBB" without the '#': all digits are decoded, validity is checked once */
+static int parse_hex(const unsigned char *s, size_t len, t_rgb *out) {
+    uint32_t v = 0;
+    uint8_t valid = 1;
+
+    if (len != 3 && len != 6) return 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t d = HEX_DIGITS[s[i]];
+        valid &= (d != 0);
+        v = (v << 4) | (uint8_t)(d - 1);
+    }
+    if (!valid) return 0;
+
+    if (len == 3) {
+        /* #abc -> #aabbcc */
+        v = ((v & 0xF00) << 12) | ((v & 0xF00) << 8)
+          | ((v & 0x0F0) << 8) | ((v & 0x0F0) << 4)
+          | ((v & 0x00F) << 4) | (v & 0x00F);
+    }
+    if (out) *out = rgb_from_u32(v);
+    return 1;
+}
+
+
+static int is_blank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+
+/* One rgb() component: integer 0..255 or percentage (decimals allowed), clamped */
+static const char *parse_component(const char *p, const char *end, uint8_t *out) {
+    uint32_t value = 0;
+    uint32_t frac = 0;
+    uint32_t scale = 1;
+    int digits = 0;
+
+    while (p < end && is_blank(*p)) p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value < 100000) value = value * 10 + (*p - '0');
+        digits++;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9') {
+            if (scale < 1000) { frac = frac * 10 + (*p - '0'); scale *= 10; }
+            digits++;
+            p++;
+        }
+    }
+    if (digits == 0) return NULL;
+
+    if (p < end && *p == '%') {
+        /* Saturate first: value * scale * 1000 would overflow for huge percentages */
+        if (value >= 100) {
+            value = 100;
+            frac = 0;
+        }
+        uint32_t permille = (value * scale + frac) * 1000 / scale / 100;
+        value = (permille * 255 + 500) / 1000;
+        p++;
+    } else if (frac * 2 >= scale && scale > 1) {
+        value++;
+    }
+    *out = (uint8_t)((value > 255) ? 255 : value);
+
+    while (p < end && is_blank(*p)) p++;
+    return p;
+}
+
+
+static int starts_with_ci(const char *s, size_t len, const char *prefix) {
+    size_t i = 0;
+
+    for (; prefix[i]; i++) {
+        if (i >= len) return 0;
+        char c = (s[i] >= 'A' && s[i] <= 'Z') ? s[i] + ('a' - 'A') : s[i];
+        if (c != prefix[i]) return 0;
+    }
+    return 1;
+}
+
+
+static int parse_rgb_func(const char *s, size_t len, t_rgb *out) {
+    const char *end = s + len;
+    const char *p;
+    uint8_t v[3];
+
+    if (starts_with_ci(s, len, "rgba(")) p = s + 5;
+    else if (starts_with_ci(s, len, "rgb(")) p = s + 4;
+    else return 0;
+
+    if (end[-1] != ')') return 0;
+    end--;
+
+    for (int i = 0; i < 3; i++) {
+        p = parse_component(p, end, &v[i]);
+        if (!p) return 0;
+        if (i < 2 && p < end && *p == ',') p++;
+    }
+    /* Optional alpha, ignored */
+    if (p < end && (*p == ',' || *p == '/')) {
+        uint8_t alpha;
+        p = parse_component(p + 1, end, &alpha);
+        if (!p) return 0;
+    }
+    if (p != end) return 0;
+
+    if (out) {
+        out->r = v[0];
+        out->g = v[1];
+        out->b = v[2];
+    }
+    return 1;
+}
+
+
+int color_parse_n(const char *spec, size_t len, t_rgb *out) {
+    if (!spec) return 0;
+
+    while (len > 0 && is_blank(spec[0])) { spec++; len--; }
+    while (len > 0 && is_blank(spec[len - 1])) len--;
+    if (len == 0) return 0;
+
+    if (spec[0] == '#') return parse_hex((const unsigned char *)spec + 1, len - 1, out);
+    if ((spec[0] == 'r' || spec[0] == 'R') && memchr(spec, '(', len)) return parse_rgb_func(spec, len, out);
+    return color_lookup_name(spec, len, out);
+}
+
+
+int color_parse(const char *spec, t_rgb *out) {
+    if (!spec) return 0;
+
+    return color_parse_n(spec, strlen(spec), out);
+}
+
+
+int color_parse8(const char *spec, uint8_t *out) {
+    t_rgb c;
+
+    if (!spec) return 0;
+
+    const char *p = spec;
+    uint32_t index = 0;
+    while (is_blank(*p)) p++;
+    if (*p >= '0' && *p <= '9') {
+        while (*p >= '0' && *p <= '9' && index <= 255) index = index * 10 + (*p++ - '0');
+        while (is_blank(*p)) p++;
+        if (*p != '\0' || index > 255) return 0;
+        if (out) *out = (uint8_t)index;
+        return 1;
+    }
+
+    if (!color_parse(spec, &c)) return 0;
+    if (out) *out = rgb_to_color8(c.r, c.g, c.b);
+    return 1;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file color_parse.h
+ * @brief Color-spec parser: "#RGB", "#RRGGBB", "rgb(r, g, b)" and CSS/X11 color names.
+ *
+ * Names are matched through a perfect hash generated offline over the name table,
+ * so a lookup costs two short hashes and a single comparison. Matching ignores case,
+ * spaces, '-' and '_' ("Light Sea Green" == "light-sea-green" == "lightseagreen").
+ * Results feed fore_color24() / put_color24(), or the 256-color palette with color_parse8().
+ */
+
+#ifndef COLOR_PARSE_H
+#define COLOR_PARSE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Parses a color spec.
+ * * Accepts "#RGB", "#RRGGBB", "rgb(r, g, b)" / "rgba(r, g, b, a)" with 0..255 or
+ * percentage components (comma or space separated, alpha ignored) and color names.
+ * Leading and trailing blanks are ignored.
+ * @param out Parsed color, left untouched on failure.
+ * @return 1 on success, 0 if the spec is invalid.
+ */
+int color_parse(const char *spec, t_rgb *out);
+
+/**
+ * @brief color_parse() on the first 'len' bytes of 'spec' (no NUL terminator needed).
+ */
+int color_parse_n(const char *spec, size_t len, t_rgb *out);
+
+/**
+ * @brief Parses a spec into a 256-color palette index.
+ * * A plain number "0".."255" is taken as the index itself, anything else goes
+ * through color_parse() and rgb_to_color8().
+ * @return 1 on success, 0 if the spec is invalid.
+ */
+int color_parse8(const char *spec, uint8_t *out);
+
+/**
+ * @brief Looks up a color name only (no hex or rgb() forms).
+ * @return 1 if the name is known, 0 otherwise.
+ */
+int color_lookup_name(const char *name, size_t len, t_rgb *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_PARSE_H */
@@ -0,0 +1,368 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_remap.h"
+
+
+#define REMAP_CHUNK 65536
+#define REMAP_IOV_MAX 64
+#define REMAP_ARENA 4096
+
+/* "38;2;255;255;255;" is the longest rewritten parameter */
+#define REMAP_OUT_MAX (REMAP_MAX_PARAMS * 17 + 3)
+
+
+enum {
+    REMAP_GROUND = 0,
+    REMAP_ESC    = 1,
+    REMAP_CSI    = 2
+};
+
+
+/* remap_fd() sink: input spans are referenced, other data is copied into the arena */
+typedef struct s_remap_fd_out {
+    int fd;
+    const char *chunk;
+    size_t chunk_len;
+    struct iovec iov[REMAP_IOV_MAX];
+    int nb_iov;
+    char arena[REMAP_ARENA];
+    size_t arena_len;
+} t_remap_fd_out;
+
+
+void remap_lut_init(t_remap_lut *lut) {
+    memset(lut, 0, sizeof(t_remap_lut));
+}
+
+
+void remap_init(t_remap *remap, const t_remap_lut *lut) {
+    remap->lut = lut;
+    remap->state = REMAP_GROUND;
+    remap->sgr = 0;
+    remap->pending_len = 0;
+}
+
+
+/* --- Rewriting --- */
+
+static char *remap_put_uint(char *p, unsigned v) {
+    char tmp[8];
+    size_t n = 0;
+
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *p++ = tmp[--n];
+    *p++ = ';';
+    return p;
+}
+
+
+/* Writes the parameters of a color on 'layer' (38, 48 or 58) */
+static char *remap_put_target(char *p, unsigned layer, const t_remap_target *target) {
+    if (target->kind == REMAP_TO_16 && layer != COLOR_LAYER_UNDERLINE) {
+        unsigned base = (layer == COLOR_LAYER_FORE) ? 30 : 40;
+        unsigned index = target->index & 15;
+        return remap_put_uint(p, (index < 8) ? base + index : base + 60 + index - 8);
+    }
+
+    p = remap_put_uint(p, layer);
+    if (target->kind == REMAP_TO_RGB) {
+        p = remap_put_uint(p, 2);
+        p = remap_put_uint(p, target->rgb.r);
+        p = remap_put_uint(p, target->rgb.g);
+        return remap_put_uint(p, target->rgb.b);
+    }
+
+    /* Palette entry, also used for base colors on the underline layer (no 16-color form) */
+    p = remap_put_uint(p, 5);
+    return remap_put_uint(p, target->index);
+}
+
+
+/*
+ * Rewrites 'seq' (ESC [ digits and semicolons m) into 'out'.
+ * Returns the new length, or 0 when no color changes.
+ */
+static size_t remap_sgr(const t_remap_lut *lut, const char *seq, size_t len, char *out) {
+    unsigned params[REMAP_MAX_PARAMS];
+    size_t nb_params = 1;
+
+    params[0] = 0;
+    for (size_t i = 2; i < len - 1; i++) {
+        if (seq[i] == ';') {
+            if (nb_params == REMAP_MAX_PARAMS) return 0;
+            params[nb_params++] = 0;
+        } else if (params[nb_params - 1] < 65536) {
+            params[nb_params - 1] = params[nb_params - 1] * 10 + (unsigned)(seq[i] - '0');
+        }
+    }
+
+    char *p = out;
+    int changed = 0;
+
+    *p++ = seq[0];
+    *p++ = '[';
+    for (size_t i = 0; i < nb_params; i++) {
+        unsigned v = params[i];
+        unsigned layer = v;
+        size_t count = 1;  /* Parameters making up this attribute */
+        const t_remap_target *target = NULL;
+        t_remap_target nearest;
+
+        if ((v >= 30 && v <= 37) || (v >= 90 && v <= 97)) {
+            layer = COLOR_LAYER_FORE;
+            target = &lut->base[(v < 90) ? v - 30 : v - 90 + 8];
+        } else if ((v >= 40 && v <= 47) || (v >= 100 && v <= 107)) {
+            layer = COLOR_LAYER_BACK;
+            target = &lut->base[(v < 100) ? v - 40 : v - 100 + 8];
+        } else if ((v == 38 || v == 48 || v == 58) && i + 2 < nb_params && params[i + 1] == 5) {
+            count = 3;
+            if (params[i + 2] < 256) target = &lut->palette[params[i + 2]];
+        } else if ((v == 38 || v == 48 || v == 58) && i + 4 < nb_params && params[i + 1] == 2) {
+            count = 5;
+            if (lut->rgb_to_256) {
+                uint8_t rgb[3];
+                for (int k = 0; k < 3; k++) rgb[k] = (params[i + 2 + k] > 255) ? 255 : (uint8_t)params[i + 2 + k];
+
+                uint8_t index = rgb_to_color8(rgb[0], rgb[1], rgb[2]);
+                target = &lut->palette[index];
+                if (target->kind == REMAP_KEEP) {
+                    nearest.kind = REMAP_TO_256;
+                    nearest.index = index;
+                    target = &nearest;
+                }
+            }
+        }
+
+        if (target && target->kind != REMAP_KEEP) {
+            p = remap_put_target(p, layer, target);
+            changed = 1;
+        } else {
+            for (size_t k = 0; k < count; k++) p = remap_put_uint(p, params[i + k]);
+        }
+        i += count - 1;
+    }
+    p[-1] = 'm';
+
+    return changed ? (size_t)(p - out) : 0;
+}
+
+
+/* --- Stream --- */
+
+/* Writes the held start of a sequence that is not rewritten */
+static int remap_release(t_remap *remap, t_remap_writer writer, void *ctx) {
+    size_t len = remap->pending_len;
+
+    remap->pending_len = 0;
+    return len == 0 || writer(ctx, remap->pending, len);
+}
+
+
+int remap_feed(t_remap *remap, const char *src, size_t len, t_remap_writer writer, void *ctx) {
+    char out[REMAP_OUT_MAX];
+    size_t i = 0;
+    size_t span = 0;  /* First byte of src not written yet */
+    size_t seq = 0;   /* Start of the current sequence, 0 when it began in an earlier chunk */
+
+    if (!remap || !writer || (!src && len)) return 0;
+
+    while (i < len) {
+        if (remap->state == REMAP_GROUND) {
+            const char *esc = memchr(src + i, 0x1B, len - i);
+            if (!esc) break;
+
+            seq = (size_t)(esc - src);
+            i = seq + 1;
+            remap->state = REMAP_ESC;
+            continue;
+        }
+
+        unsigned char c = (unsigned char)src[i];
+
+        if (remap->state == REMAP_ESC) {
+            if (c == '[') {
+                remap->state = REMAP_CSI;
+                remap->sgr = 1;
+                i++;
+                continue;
+            }
+            /* Not a CSI, 'c' is read again from ground (it may be another ESC) */
+            remap->state = REMAP_GROUND;
+            if (!remap_release(remap, writer, ctx)) return 0;
+            continue;
+        }
+
+        if ((c >= '0' && c <= '9') || c == ';') {
+            i++;
+            continue;
+        }
+        if (c >= 0x20 && c <= 0x3F) {
+            /* Private marker, colon or intermediate: not rewritten */
+            remap->sgr = 0;
+            i++;
+            continue;
+        }
+
+        remap->state = REMAP_GROUND;
+        if (c < 0x40 || c > 0x7E) {
+            /* Control character or ESC: the sequence is cancelled, the byte is read again */
+            if (!remap_release(remap, writer, ctx)) return 0;
+            continue;
+        }
+
+        i++;
+        size_t n = 0;
+        size_t held = remap->pending_len;
+
+        if (c == 'm' && remap->sgr) {
+            if (held > 0) {
+                if (held + i <= REMAP_SEQ_MAX) {
+                    memcpy(remap->pending + held, src, i);
+                    n = remap_sgr(remap->lut, remap->pending, held + i, out);
+                }
+            } else if (i - seq <= REMAP_SEQ_MAX) {
+                n = remap_sgr(remap->lut, src + seq, i - seq, out);
+            }
+        }
+
+        if (n == 0) {
+            if (!remap_release(remap, writer, ctx)) return 0;
+            continue;
+        }
+
+        remap->pending_len = 0;
+        if (held == 0 && seq > span && !writer(ctx, src + span, seq - span)) return 0;
+        if (!writer(ctx, out, n)) return 0;
+        span = i;
+    }
+
+    /* End of chunk inside a sequence that may still be rewritten: hold it */
+    if (remap->state == REMAP_ESC || (remap->state == REMAP_CSI && remap->sgr)) {
+        size_t held = remap->pending_len;
+        size_t start = (held > 0) ? 0 : seq;
+
+        if (held + len - start <= REMAP_SEQ_MAX) {
+            if (start > span && !writer(ctx, src + span, start - span)) return 0;
+            memcpy(remap->pending + held, src + start, len - start);
+            remap->pending_len = held + len - start;
+            return 1;
+        }
+        remap->sgr = 0;
+    }
+
+    if (!remap_release(remap, writer, ctx)) return 0;
+    return span == len || writer(ctx, src + span, len - span);
+}
+
+
+int remap_finish(t_remap *remap, t_remap_writer writer, void *ctx) {
+    if (!remap || !writer) return 0;
+
+    int ok = remap_release(remap, writer, ctx);
+    remap_init(remap, remap->lut);
+    return ok;
+}
+
+
+/* --- File descriptors --- */
+
+/* Writes every iovec, resuming after partial writes */
+static int remap_writev(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 1;
+}
+
+
+static int remap_fd_flush(t_remap_fd_out *o) {
+    int ok = remap_writev(o->fd, o->iov, o->nb_iov);
+
+    o->nb_iov = 0;
+    o->arena_len = 0;
+    return ok;
+}
+
+
+static int remap_fd_writer(void *ctx, const char *data, size_t len) {
+    t_remap_fd_out *o = ctx;
+    int in_chunk = (data >= o->chunk && data < o->chunk + o->chunk_len);
+
+    if (o->nb_iov == REMAP_IOV_MAX || (!in_chunk && o->arena_len + len > REMAP_ARENA)) {
+        if (!remap_fd_flush(o)) return 0;
+    }
+    if (!in_chunk) {
+        memcpy(o->arena + o->arena_len, data, len);
+        data = o->arena + o->arena_len;
+        o->arena_len += len;
+    }
+
+    /* Consecutive arena copies share one iovec */
+    if (o->nb_iov > 0) {
+        struct iovec *last = &o->iov[o->nb_iov - 1];
+        if ((const char *)last->iov_base + last->iov_len == data) {
+            last->iov_len += len;
+            return 1;
+        }
+    }
+
+    o->iov[o->nb_iov].iov_base = (void *)data;
+    o->iov[o->nb_iov].iov_len = len;
+    o->nb_iov++;
+    return 1;
+}
+
+
+int remap_fd(int in_fd, int out_fd, const t_remap_lut *lut) {
+    char in[REMAP_CHUNK];
+    t_remap_fd_out o;
+    t_remap remap;
+
+    if (!lut) return 0;
+
+    o.fd = out_fd;
+    o.nb_iov = 0;
+    o.arena_len = 0;
+    remap_init(&remap, lut);
+
+    for (;;) {
+        ssize_t n = read(in_fd, in, REMAP_CHUNK);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return 0;
+        if (n == 0) break;
+
+        o.chunk = in;
+        o.chunk_len = (size_t)n;
+        if (!remap_feed(&remap, in, (size_t)n, remap_fd_writer, &o)) return 0;
+
+        /* Spans point into 'in', written before it is reused */
+        if (!remap_fd_flush(&o)) return 0;
+    }
+
+    o.chunk = NULL;
+    o.chunk_len = 0;
+    return remap_finish(&remap, remap_fd_writer, &o) && remap_fd_flush(&o);
+}
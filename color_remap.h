@@ -0,0 +1,111 @@
+/**
+ * @file color_remap.h
+ * @brief Streaming SGR color remapping through a lookup table, for replaying captured output.
+ *
+ * Colors of SGR sequences are rewritten through a t_remap_lut: the 16 base colors
+ * (30-37, 90-97 and their backgrounds), the 256-color palette (38;5 / 48;5 / 58;5), and
+ * TrueColor (38;2 ...) optionally brought down to the nearest 256-color entry. Each entry
+ * can become a base color (theme swap), a palette index or an RGB value.
+ *
+ * Everything else passes through byte for byte: text and unchanged sequences reach the
+ * writer as spans of the input buffer, without copy. Only rewritten sequences and the
+ * few bytes of a sequence split across two chunks are held in the fixed-size state.
+ * Colon sub-parameters (38:2::r:g:b) are left as they are.
+ */
+
+#ifndef COLOR_REMAP_H
+#define COLOR_REMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest SGR sequence considered for rewriting; longer ones pass through unchanged */
+#define REMAP_SEQ_MAX 256
+
+/** Most parameters in a rewritten sequence */
+#define REMAP_MAX_PARAMS 32
+
+/**
+ * @brief What a color becomes.
+ */
+typedef enum {
+    REMAP_KEEP   = 0, ///< Unchanged
+    REMAP_TO_16  = 1, ///< Base color 'index' (0-15), as 30-37 / 90-97 (58;5;n for underline)
+    REMAP_TO_256 = 2, ///< Palette entry 'index', as 38;5;n
+    REMAP_TO_RGB = 3  ///< TrueColor 'rgb', as 38;2;r;g;b
+} RemapKind;
+
+/**
+ * @brief Replacement of one color.
+ */
+typedef struct s_remap_target {
+    uint8_t kind;   /**< RemapKind */
+    uint8_t index;
+    t_rgb rgb;
+} t_remap_target;
+
+/**
+ * @brief Lookup table, shared read-only between filters.
+ */
+typedef struct s_remap_lut {
+    t_remap_target base[16];      /**< 30-37 / 90-97 and 40-47 / 100-107 */
+    t_remap_target palette[256];  /**< 38;5;n, 48;5;n and 58;5;n */
+    unsigned char rgb_to_256;     /**< Replace 38;2 colors by their nearest palette entry */
+} t_remap_lut;
+
+/**
+ * @brief Filter state.
+ */
+typedef struct s_remap {
+    const t_remap_lut *lut;
+    uint8_t state;
+    uint8_t sgr;                 /**< The current CSI can still be a rewritable SGR */
+    size_t pending_len;
+    char pending[REMAP_SEQ_MAX]; /**< Start of a sequence split across chunks */
+} t_remap;
+
+/**
+ * @brief Output callback; data is only valid during the call.
+ * @return 1 on success, 0 to stop the filter.
+ */
+typedef int (*t_remap_writer)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Fills a table that keeps every color.
+ */
+void remap_lut_init(t_remap_lut *lut);
+
+/**
+ * @brief Initializes (or resets) a filter; the table must outlive it.
+ */
+void remap_init(t_remap *remap, const t_remap_lut *lut);
+
+/**
+ * @brief Filters a chunk of any size; sequences may be split across chunks.
+ * @return 1 on success, 0 if the writer failed.
+ */
+int remap_feed(t_remap *remap, const char *src, size_t len, t_remap_writer writer, void *ctx);
+
+/**
+ * @brief Writes out an unfinished sequence left by the last chunk and resets the filter.
+ * @return 1 on success, 0 if the writer failed.
+ */
+int remap_finish(t_remap *remap, t_remap_writer writer, void *ctx);
+
+/**
+ * @brief Filters everything readable from in_fd to out_fd; spans are gathered with writev.
+ * @return 1 on success, 0 on I/O error.
+ */
+int remap_fd(int in_fd, int out_fd, const t_remap_lut *lut);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_REMAP_H */
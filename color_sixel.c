@@ -0,0 +1,606 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_sixel.h"
+#include "color_stats.h"
+
+
+#define SIXEL_CHUNK 4096
+#define EXACT_SLOTS 1024
+#define HIST_BITS 5
+#define HIST_SIZE (1 << (3 * HIST_BITS))
+#define NEAREST_CACHE_SIZE 16384
+
+
+/* Median-cut box, bounds in histogram units (inclusive) */
+typedef struct s_sixel_box {
+    uint8_t lo[3];
+    uint8_t hi[3];
+    uint32_t count;
+} t_sixel_box;
+
+
+/* Output sink: a caller buffer (writer == NULL) or a chunk flushed to a writer */
+typedef struct s_sixel_out {
+    char *buf;
+    size_t len;
+    size_t cap;
+    t_sixel_writer writer;
+    void *ctx;
+    int failed;
+    size_t flushed;  /* Bytes already handed to the writer */
+} t_sixel_out;
+
+
+static const uint8_t BAYER8[8][8] = {
+    { 0, 32,  8, 40,  2, 34, 10, 42},
+    {48, 16, 56, 24, 50, 18, 58, 26},
+    {12, 44,  4, 36, 14, 46,  6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22},
+    { 3, 35, 11, 43,  1, 33,  9, 41},
+    {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47,  7, 39, 13, 45,  5, 37},
+    {63, 31, 55, 23, 61, 29, 53, 21}
+};
+
+
+/* a * b, 0 if it overflows size_t */
+static int sixel_mul(size_t a, size_t b, size_t *out) {
+    if (b != 0 && a > SIZE_MAX / b) return 0;
+    *out = a * b;
+    return 1;
+}
+
+
+/* --- Quantization --- */
+
+static uint32_t rgb_key(const t_rgb *c) {
+    return (uint32_t)c->r << 16 | (uint32_t)c->g << 8 | c->b;
+}
+
+
+static size_t hist_index(unsigned r, unsigned g, unsigned b) {
+    return (size_t)r << (2 * HIST_BITS) | (size_t)g << HIST_BITS | b;
+}
+
+
+/* Keeps the image colors as they are when there are few enough of them */
+static int exact_palette(const t_rgb *pixels, size_t n, size_t max_colors, t_sixel_palette *palette) {
+    uint32_t keys[EXACT_SLOTS];
+    size_t count = 0;
+
+    memset(keys, 0xFF, sizeof(keys));
+    for (size_t i = 0; i < n; i++) {
+        uint32_t key = rgb_key(&pixels[i]);
+        size_t slot = (key * 2654435761u) >> (32 - 10);
+
+        while (keys[slot] != key && keys[slot] != UINT32_MAX) slot = (slot + 1) & (EXACT_SLOTS - 1);
+        if (keys[slot] == key) continue;
+
+        if (count == max_colors) return 0;
+        keys[slot] = key;
+        palette->colors[count++] = pixels[i];
+    }
+    palette->size = (uint16_t)count;
+    return 1;
+}
+
+
+/* Shrinks a box to the bins actually used and recounts it */
+static void box_shrink(t_sixel_box *box, const uint32_t *hist) {
+    uint8_t lo[3] = {31, 31, 31};
+    uint8_t hi[3] = {0, 0, 0};
+    uint32_t count = 0;
+
+    for (unsigned r = box->lo[0]; r <= box->hi[0]; r++) {
+        for (unsigned g = box->lo[1]; g <= box->hi[1]; g++) {
+            for (unsigned b = box->lo[2]; b <= box->hi[2]; b++) {
+                uint32_t n = hist[hist_index(r, g, b)];
+                if (!n) continue;
+                count += n;
+                if (r < lo[0]) lo[0] = r;
+                if (r > hi[0]) hi[0] = r;
+                if (g < lo[1]) lo[1] = g;
+                if (g > hi[1]) hi[1] = g;
+                if (b < lo[2]) lo[2] = b;
+                if (b > hi[2]) hi[2] = b;
+            }
+        }
+    }
+    memcpy(box->lo, lo, 3);
+    memcpy(box->hi, hi, 3);
+    box->count = count;
+}
+
+
+static int box_axis(const t_sixel_box *box) {
+    int axis = 0;
+
+    for (int k = 1; k < 3; k++) {
+        if (box->hi[k] - box->lo[k] > box->hi[axis] - box->lo[axis]) axis = k;
+    }
+    return axis;
+}
+
+
+/* Splits at the median of the longest axis, 'right' gets the upper part */
+static void box_split(t_sixel_box *box, t_sixel_box *right, const uint32_t *hist) {
+    int axis = box_axis(box);
+    uint32_t slices[1 << HIST_BITS] = {0};
+    unsigned v[3];
+
+    for (v[0] = box->lo[0]; v[0] <= box->hi[0]; v[0]++) {
+        for (v[1] = box->lo[1]; v[1] <= box->hi[1]; v[1]++) {
+            for (v[2] = box->lo[2]; v[2] <= box->hi[2]; v[2]++) {
+                slices[v[axis]] += hist[hist_index(v[0], v[1], v[2])];
+            }
+        }
+    }
+
+    unsigned cut = box->hi[axis] - 1;
+    uint64_t acc = 0;
+    for (unsigned s = box->lo[axis]; s < box->hi[axis]; s++) {
+        acc += slices[s];
+        if (2 * acc >= box->count) {
+            cut = s;
+            break;
+        }
+    }
+
+    *right = *box;
+    box->hi[axis] = (uint8_t)cut;
+    right->lo[axis] = (uint8_t)(cut + 1);
+    box_shrink(box, hist);
+    box_shrink(right, hist);
+}
+
+
+static uint8_t expand5(unsigned v) {
+    return (uint8_t)(v << 3 | v >> 2);
+}
+
+
+static t_rgb box_color(const t_sixel_box *box, const uint32_t *hist) {
+    uint64_t sum[3] = {0, 0, 0};
+    t_rgb c = {0, 0, 0};
+
+    for (unsigned r = box->lo[0]; r <= box->hi[0]; r++) {
+        for (unsigned g = box->lo[1]; g <= box->hi[1]; g++) {
+            for (unsigned b = box->lo[2]; b <= box->hi[2]; b++) {
+                uint32_t n = hist[hist_index(r, g, b)];
+                sum[0] += (uint64_t)n * expand5(r);
+                sum[1] += (uint64_t)n * expand5(g);
+                sum[2] += (uint64_t)n * expand5(b);
+            }
+        }
+    }
+    if (box->count) {
+        c.r = (uint8_t)((sum[0] + box->count / 2) / box->count);
+        c.g = (uint8_t)((sum[1] + box->count / 2) / box->count);
+        c.b = (uint8_t)((sum[2] + box->count / 2) / box->count);
+    }
+    return c;
+}
+
+
+static int median_cut(const t_rgb *pixels, size_t n, size_t max_colors, t_sixel_palette *palette) {
+    uint32_t *hist = calloc(HIST_SIZE, sizeof(uint32_t));
+    t_sixel_box boxes[SIXEL_MAX_COLORS];
+    size_t nb = 1;
+
+    if (!hist) return 0;
+
+    for (size_t i = 0; i < n; i++) {
+        hist[hist_index(pixels[i].r >> 3, pixels[i].g >> 3, pixels[i].b >> 3)]++;
+    }
+
+    boxes[0] = (t_sixel_box){{0, 0, 0}, {31, 31, 31}, 0};
+    box_shrink(&boxes[0], hist);
+
+    /* Split the most populated box weighted by its extent until the palette is full */
+    while (nb < max_colors) {
+        size_t best = nb;
+        uint64_t best_score = 0;
+
+        for (size_t i = 0; i < nb; i++) {
+            int axis = box_axis(&boxes[i]);
+            uint64_t score = (uint64_t)boxes[i].count * (boxes[i].hi[axis] - boxes[i].lo[axis]);
+            if (score > best_score) {
+                best_score = score;
+                best = i;
+            }
+        }
+        if (best == nb) break;
+
+        box_split(&boxes[best], &boxes[nb], hist);
+        nb++;
+    }
+
+    for (size_t i = 0; i < nb; i++) palette->colors[i] = box_color(&boxes[i], hist);
+    palette->size = (uint16_t)nb;
+
+    free(hist);
+    return 1;
+}
+
+
+int sixel_quantize(const t_rgb *pixels, size_t width, size_t height, size_t max_colors, t_sixel_palette *palette) {
+    size_t n;
+
+    if (!pixels || !palette || !sixel_mul(width, height, &n) || n == 0 || max_colors == 0 || max_colors > SIXEL_MAX_COLORS) return 0;
+
+    if (exact_palette(pixels, n, max_colors, palette)) return 1;
+    return median_cut(pixels, n, max_colors, palette);
+}
+
+
+/* --- Mapping --- */
+
+/* Palette entry sorted by green, the search walks outwards and stops once green alone is too far */
+typedef struct s_sixel_entry {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t index;
+} t_sixel_entry;
+
+
+static size_t sort_palette(const t_sixel_palette *palette, t_sixel_entry *sorted) {
+    size_t n = palette->size;
+
+    for (size_t i = 0; i < n; i++) {
+        t_sixel_entry e = {palette->colors[i].r, palette->colors[i].g, palette->colors[i].b, (uint8_t)i};
+        size_t j = i;
+        while (j > 0 && sorted[j - 1].g > e.g) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = e;
+    }
+    return n;
+}
+
+
+static int entry_dist(const t_sixel_entry *e, int r, int g, int b) {
+    int dr = r - e->r;
+    int dg = g - e->g;
+    int db = b - e->b;
+
+    return dr * dr + dg * dg + db * db;
+}
+
+
+static uint8_t nearest(const t_sixel_entry *sorted, size_t n, int r, int g, int b) {
+    size_t lo = 0, hi = n;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (sorted[mid].g < g) lo = mid + 1;
+        else hi = mid;
+    }
+
+    uint8_t best = sorted[(lo < n) ? lo : n - 1].index;
+    int best_d = INT32_MAX;
+    size_t up = lo;
+    size_t down = lo;
+
+    while (up < n || down > 0) {
+        if (up < n) {
+            int dg = sorted[up].g - g;
+            if (dg * dg >= best_d) {
+                up = n;
+            } else {
+                int d = entry_dist(&sorted[up], r, g, b);
+                if (d < best_d) {
+                    best_d = d;
+                    best = sorted[up].index;
+                }
+                up++;
+            }
+        }
+        if (down > 0) {
+            int dg = g - sorted[down - 1].g;
+            if (dg * dg >= best_d) {
+                down = 0;
+            } else {
+                int d = entry_dist(&sorted[down - 1], r, g, b);
+                if (d < best_d) {
+                    best_d = d;
+                    best = sorted[down - 1].index;
+                }
+                down--;
+            }
+        }
+    }
+    return best;
+}
+
+
+/* Dither amplitude: the spacing of a regular grid with as many colors as the palette */
+static int dither_step(size_t colors) {
+    int levels = 2;
+
+    while ((size_t)(levels + 1) * (levels + 1) * (levels + 1) <= colors) levels++;
+    return 255 / (levels - 1);
+}
+
+
+static int clamp8(int v) {
+    return (v < 0) ? 0 : (v > 255) ? 255 : v;
+}
+
+
+int sixel_map(const t_rgb *pixels, size_t width, size_t height, const t_sixel_palette *palette,
+              SixelDither dither, uint8_t *indices) {
+    size_t area;
+
+    if (!pixels || !palette || !indices || palette->size == 0 || palette->size > SIXEL_MAX_COLORS) return 0;
+    if (!sixel_mul(width, height, &area)) return 0;
+
+    /* Direct-mapped cache of full 24-bit colors, exact palettes stay exact */
+    uint32_t *keys = malloc(NEAREST_CACHE_SIZE * sizeof(uint32_t));
+    uint8_t *values = malloc(NEAREST_CACHE_SIZE);
+    if (!keys || !values) {free(keys);free(values);return 0;}
+    memset(keys, 0xFF, NEAREST_CACHE_SIZE * sizeof(uint32_t));
+
+    t_sixel_entry sorted[SIXEL_MAX_COLORS];
+    size_t n = sort_palette(palette, sorted);
+    int step = dither_step(palette->size);
+
+    for (size_t y = 0; y < height; y++) {
+        const t_rgb *row = pixels + y * width;
+        uint8_t *out = indices + y * width;
+
+        for (size_t x = 0; x < width; x++) {
+            int r = row[x].r, g = row[x].g, b = row[x].b;
+
+            if (dither == SIXEL_DITHER_ORDERED) {
+                int offset = ((2 * BAYER8[y & 7][x & 7] - 63) * step) / 128;
+                r = clamp8(r + offset);
+                g = clamp8(g + offset);
+                b = clamp8(b + offset);
+            }
+
+            uint32_t key = (uint32_t)r << 16 | (uint32_t)g << 8 | (uint32_t)b;
+            size_t slot = (key * 2654435761u) >> (32 - 14);
+            if (keys[slot] != key) {
+                keys[slot] = key;
+                values[slot] = nearest(sorted, n, r, g, b);
+            }
+            out[x] = values[slot];
+        }
+    }
+
+    free(keys);
+    free(values);
+    return 1;
+}
+
+
+/* --- Encoding --- */
+
+static void out_flush(t_sixel_out *o) {
+    if (o->writer && o->len > 0 && !o->failed) {
+        if (!o->writer(o->ctx, o->buf, o->len)) o->failed = 1;
+        o->flushed += o->len;
+    }
+    o->len = 0;
+}
+
+
+static void out_put(t_sixel_out *o, const char *data, size_t len) {
+    if (o->failed) return;
+    if (o->len + len > o->cap) {
+        if (!o->writer) {
+            o->failed = 1;
+            return;
+        }
+        out_flush(o);
+    }
+    memcpy(o->buf + o->len, data, len);
+    o->len += len;
+}
+
+
+static void out_char(t_sixel_out *o, char c) {
+    if (o->len < o->cap) o->buf[o->len++] = c;
+    else out_put(o, &c, 1);
+}
+
+
+static void out_uint(t_sixel_out *o, size_t v) {
+    char tmp[24];
+    size_t i = sizeof(tmp);
+
+    do {
+        tmp[--i] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    out_put(o, tmp + i, sizeof(tmp) - i);
+}
+
+
+static void out_run(t_sixel_out *o, uint8_t bits, size_t run) {
+    char c = (char)('?' + bits);
+
+    if (run > 3) {
+        out_char(o, '!');
+        out_uint(o, run);
+        out_char(o, c);
+        return;
+    }
+    while (run--) out_char(o, c);
+}
+
+
+/* One color row of a band, the trailing empty sixels are already cut (n = last used column + 1) */
+static void out_sixels(t_sixel_out *o, const uint8_t *bits, size_t n) {
+    uint8_t prev = bits[0];
+    size_t run = 1;
+
+    for (size_t x = 1; x < n; x++) {
+        if (bits[x] == prev) {
+            run++;
+            continue;
+        }
+        out_run(o, prev, run);
+        prev = bits[x];
+        run = 1;
+    }
+    out_run(o, prev, run);
+}
+
+
+static int encode(t_sixel_out *o, const uint8_t *indices, size_t width, size_t height, const t_sixel_palette *palette) {
+    size_t area, bits_size;
+
+    if (!indices || !palette || width == 0 || height == 0 || palette->size == 0 || palette->size > SIXEL_MAX_COLORS) return 0;
+    if (!sixel_mul(width, height, &area) || !sixel_mul(palette->size, width, &bits_size)) return 0;
+
+    /* bits[c * width + x]: the sixel of color c in column x, last[c]: last used column + 1 */
+    uint8_t *bits = calloc(bits_size, 1);
+    size_t last[SIXEL_MAX_COLORS] = {0};
+    if (!bits) return 0;
+
+    out_put(o, get_ansi_esc_char(), get_ansi_esc_len());
+    out_put(o, "P0;1;0q\"1;1;", 12);
+    out_uint(o, width);
+    out_char(o, ';');
+    out_uint(o, height);
+
+    for (size_t i = 0; i < palette->size; i++) {
+        const t_rgb *c = &palette->colors[i];
+        out_char(o, '#');
+        out_uint(o, i);
+        out_put(o, ";2;", 3);
+        out_uint(o, (c->r * 100u + 127) / 255);
+        out_char(o, ';');
+        out_uint(o, (c->g * 100u + 127) / 255);
+        out_char(o, ';');
+        out_uint(o, (c->b * 100u + 127) / 255);
+    }
+
+    for (size_t y0 = 0; y0 < height && !o->failed; y0 += 6) {
+        size_t rows = (height - y0 < 6) ? height - y0 : 6;
+
+        for (size_t k = 0; k < rows; k++) {
+            const uint8_t *row = indices + (y0 + k) * width;
+            for (size_t x = 0; x < width; x++) {
+                uint8_t c = row[x];
+                if (c >= palette->size) {
+                    free(bits);
+                    return 0;
+                }
+                bits[c * width + x] |= (uint8_t)(1 << k);
+                if (x + 1 > last[c]) last[c] = x + 1;
+            }
+        }
+
+        int first = 1;
+        for (size_t c = 0; c < palette->size; c++) {
+            if (!last[c]) continue;
+            if (!first) out_char(o, '$');
+            first = 0;
+
+            out_char(o, '#');
+            out_uint(o, c);
+            out_sixels(o, bits + c * width, last[c]);
+
+            memset(bits + c * width, 0, last[c]);
+            last[c] = 0;
+        }
+        if (y0 + 6 < height) out_char(o, '-');
+    }
+
+    out_put(o, get_ansi_esc_char(), get_ansi_esc_len());
+    out_char(o, '\\');
+
+    free(bits);
+    if (!o->failed) color_stats_sequence(STATS_OTHER, o->flushed + o->len);
+    return !o->failed;
+}
+
+
+size_t sixel_size_max(size_t width, size_t height, const t_sixel_palette *palette) {
+    size_t row, body;
+
+    if (!palette || width > SIZE_MAX / 6 - 5) return 0;
+
+    size_t bands = height / 6 + (height % 6 != 0);
+    size_t colors = (palette->size < 6 * width) ? palette->size : 6 * width;
+
+    /* Prefix and terminator, header with raster attributes, "#nnn;2;rrr;ggg;bbb" per color,
+       then per band "$#nnn" plus one sixel per column for each color, and '-' */
+    size_t header = 2 * get_ansi_esc_len() + 64 + (size_t)palette->size * 20 + 1;
+    if (!sixel_mul(colors, width + 5, &row) || !sixel_mul(bands, row + 1, &body) || body > SIZE_MAX - header) return 0;
+    return header + body;
+}
+
+
+size_t sixel_encode(char *dst, size_t size, const uint8_t *indices, size_t width, size_t height,
+                    const t_sixel_palette *palette) {
+    if (!dst || size == 0) return 0;
+
+    t_sixel_out o = {dst, 0, size - 1, NULL, NULL, 0, 0};
+    if (!encode(&o, indices, width, height, palette)) return 0;
+
+    dst[o.len] = '\0';
+    return o.len;
+}
+
+
+int sixel_write(t_sixel_writer writer, void *ctx, const uint8_t *indices, size_t width, size_t height,
+                const t_sixel_palette *palette) {
+    char chunk[SIXEL_CHUNK];
+
+    if (!writer) return 0;
+
+    t_sixel_out o = {chunk, 0, SIXEL_CHUNK, writer, ctx, 0, 0};
+    int ok = encode(&o, indices, width, height, palette);
+    out_flush(&o);
+
+    return ok && !o.failed;
+}
+
+
+int sixel_write_image(t_sixel_writer writer, void *ctx, const t_rgb *pixels, size_t width, size_t height,
+                      size_t max_colors, SixelDither dither) {
+    t_sixel_palette palette;
+
+    if (!sixel_quantize(pixels, width, height, max_colors, &palette)) return 0;
+
+    /* sixel_quantize() rejected width * height overflows */
+    uint8_t *indices = malloc(width * height);
+    if (!indices) return 0;
+
+    int ok = sixel_map(pixels, width, height, &palette, dither, indices)
+             && sixel_write(writer, ctx, indices, width, height, &palette);
+
+    free(indices);
+    return ok;
+}
+
+
+int sixel_fd_writer(void *ctx, const char *data, size_t len) {
+    int fd = *(const int *)ctx;
+    size_t syscalls = 0;
+
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            color_stats_flush(syscalls);
+            return 0;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    color_stats_flush(syscalls);
+    return 1;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file color_sixel.h
+ * @brief DEC sixel encoder: palette quantization, optional ordered dither, run-length output.
+ *
+ * An RGB image goes through three steps, each usable on its own:
+ *
+ *     sixel_quantize()  up to 256 colors (exact when the image has few colors, median cut otherwise)
+ *     sixel_map()       one palette index per pixel, optionally with an 8x8 Bayer dither
+ *     sixel_encode()    DCS sixel data into a caller buffer, or sixel_write() through a writer
+ *
+ * sixel_write_image() chains them. Output starts with the init_color() escape prefix,
+ * runs of more than three identical sixels are compressed ("!<n><sixel>") and empty
+ * trailing sixels of each color row are dropped.
+ */
+
+#ifndef COLOR_SIXEL_H
+#define COLOR_SIXEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIXEL_MAX_COLORS 256
+
+/**
+ * @brief Dithering applied when mapping pixels to the palette.
+ */
+typedef enum {
+    SIXEL_DITHER_NONE    = 0, ///< Nearest color, best for charts and flat colors
+    SIXEL_DITHER_ORDERED = 1  ///< 8x8 Bayer matrix, smooths banding in photos and gradients
+} SixelDither;
+
+/**
+ * @brief Image palette.
+ */
+typedef struct s_sixel_palette {
+    uint16_t size;
+    t_rgb colors[SIXEL_MAX_COLORS];
+} t_sixel_palette;
+
+/**
+ * @brief Streaming output callback.
+ * @return Non-zero on success, 0 to abort the encoding.
+ */
+typedef int (*t_sixel_writer)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Builds a palette of at most max_colors colors (1..256).
+ * * Images with max_colors distinct colors or fewer keep them exactly; others go through
+ * a median cut over a 15-bit histogram.
+ * @param pixels width * height pixels, row-major.
+ * @return 1 on success, 0 on invalid arguments (width * height overflowing included) or allocation failure.
+ */
+int sixel_quantize(const t_rgb *pixels, size_t width, size_t height, size_t max_colors, t_sixel_palette *palette);
+
+/**
+ * @brief Maps every pixel to its nearest palette entry.
+ * @param indices Destination, width * height bytes.
+ * @return 1 on success, 0 on invalid arguments or allocation failure.
+ */
+int sixel_map(const t_rgb *pixels, size_t width, size_t height, const t_sixel_palette *palette,
+              SixelDither dither, uint8_t *indices);
+
+/**
+ * @brief Upper bound of the buffer size sixel_encode() needs, NUL terminator included.
+ * @return The bound, or 0 if it does not fit in a size_t.
+ */
+size_t sixel_size_max(size_t width, size_t height, const t_sixel_palette *palette);
+
+/**
+ * @brief Encodes an indexed image into a contiguous buffer.
+ * * The result is NUL-terminated. Sizing dst with sixel_size_max() always fits; smaller
+ * buffers work as long as the actual output fits.
+ * @return Number of bytes written (NUL excluded), or 0 if dst is too small or the arguments are invalid.
+ */
+size_t sixel_encode(char *dst, size_t size, const uint8_t *indices, size_t width, size_t height,
+                    const t_sixel_palette *palette);
+
+/**
+ * @brief Encodes an indexed image through a writer, in chunks of a few kilobytes.
+ * @return 1 on success, 0 if the writer failed or the arguments are invalid.
+ */
+int sixel_write(t_sixel_writer writer, void *ctx, const uint8_t *indices, size_t width, size_t height,
+                const t_sixel_palette *palette);
+
+/**
+ * @brief Quantizes, maps and writes an RGB image (the index buffer is allocated internally).
+ * @return 1 on success, 0 on error.
+ */
+int sixel_write_image(t_sixel_writer writer, void *ctx, const t_rgb *pixels, size_t width, size_t height,
+                      size_t max_colors, SixelDither dither);
+
+/**
+ * @brief Ready-made writer, ctx points to an int file descriptor.
+ */
+int sixel_fd_writer(void *ctx, const char *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_SIXEL_H */
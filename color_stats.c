@@ -0,0 +1,501 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_stats.h"
+
+
+#define STATS_REPORT_MAX 1024
+
+
+/* Counter slots of a thread block, in the order of t_color_stats */
+enum {
+    FIELD_SEQUENCES = 0,
+    FIELD_SEQUENCE_BYTES = NB_STATS_CATEGORIES,
+    FIELD_TEXT = 2 * NB_STATS_CATEGORIES,
+    FIELD_FLUSHES,
+    FIELD_SYSCALLS,
+    FIELD_FRAMES,
+    NB_FIELDS
+};
+
+
+/* Written only by its thread (relaxed load + store, no locked instruction), read by snapshots */
+typedef struct s_stats_block {
+    _Atomic uint64_t fields[NB_FIELDS];
+    struct s_stats_block *next;
+} t_stats_block;
+
+
+static const char *STATS_CATEGORY_NAMES[NB_STATS_CATEGORIES] = {
+    "fore", "back", "style", "cursor", "screen", "color8", "color24", "other"
+};
+
+
+static atomic_int g_stats_enabled;
+static pthread_mutex_t g_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static t_stats_block *g_stats_blocks;
+static uint64_t g_stats_retired[NB_FIELDS];  /* Counts of exited threads */
+static uint64_t g_stats_base[NB_FIELDS];     /* Totals at the last reset */
+static pthread_once_t g_stats_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t g_stats_key;
+static _Thread_local t_stats_block *tl_stats_block;
+
+static pthread_mutex_t g_stats_dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_stats_dump_cond = PTHREAD_COND_INITIALIZER;
+static int g_stats_dump_fd = -1;
+static unsigned g_stats_dump_interval;
+static int g_stats_dump_running;
+
+
+/* --- Thread blocks --- */
+
+/* Folds the block of an exiting thread into the retired totals */
+static void stats_retire(void *arg) {
+    t_stats_block *block = arg;
+
+    pthread_mutex_lock(&g_stats_lock);
+    for (t_stats_block **p = &g_stats_blocks; *p; p = &(*p)->next) {
+        if (*p == block) {
+            *p = block->next;
+            break;
+        }
+    }
+    for (int i = 0; i < NB_FIELDS; i++) {
+        g_stats_retired[i] += atomic_load_explicit(&block->fields[i], memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&g_stats_lock);
+    free(block);
+}
+
+
+static void stats_key_init(void) {
+    pthread_key_create(&g_stats_key, stats_retire);
+}
+
+
+static t_stats_block *stats_register(void) {
+    t_stats_block *block = calloc(1, sizeof(t_stats_block));
+    if (!block) return NULL;
+
+    pthread_once(&g_stats_key_once, stats_key_init);
+    pthread_setspecific(g_stats_key, block);
+
+    pthread_mutex_lock(&g_stats_lock);
+    block->next = g_stats_blocks;
+    g_stats_blocks = block;
+    pthread_mutex_unlock(&g_stats_lock);
+
+    tl_stats_block = block;
+    return block;
+}
+
+
+/* Block of the calling thread, NULL when recording is off */
+static t_stats_block *stats_block(void) {
+    if (!atomic_load_explicit(&g_stats_enabled, memory_order_relaxed)) return NULL;
+    return tl_stats_block ? tl_stats_block : stats_register();
+}
+
+
+static void stats_bump(t_stats_block *block, int field, uint64_t n) {
+    uint64_t v = atomic_load_explicit(&block->fields[field], memory_order_relaxed);
+    atomic_store_explicit(&block->fields[field], v + n, memory_order_relaxed);
+}
+
+
+void color_stats_enable(int enabled) {
+    atomic_store_explicit(&g_stats_enabled, enabled != 0, memory_order_relaxed);
+}
+
+
+int color_stats_enabled(void) {
+    return atomic_load_explicit(&g_stats_enabled, memory_order_relaxed);
+}
+
+
+void color_stats_sequence(StatsCategory category, size_t len) {
+    t_stats_block *block = stats_block();
+    if (!block || (unsigned)category >= NB_STATS_CATEGORIES) return;
+
+    stats_bump(block, FIELD_SEQUENCES + category, 1);
+    stats_bump(block, FIELD_SEQUENCE_BYTES + category, len);
+}
+
+
+void color_stats_text(size_t len) {
+    t_stats_block *block = stats_block();
+    if (block) stats_bump(block, FIELD_TEXT, len);
+}
+
+
+void color_stats_flush(size_t syscalls) {
+    t_stats_block *block = stats_block();
+    if (!block) return;
+
+    stats_bump(block, FIELD_FLUSHES, 1);
+    stats_bump(block, FIELD_SYSCALLS, syscalls);
+}
+
+
+void color_stats_frame(void) {
+    t_stats_block *block = stats_block();
+    if (block) stats_bump(block, FIELD_FRAMES, 1);
+}
+
+
+static void stats_to_fields(const t_color_stats *stats, uint64_t *fields) {
+    for (int i = 0; i < NB_STATS_CATEGORIES; i++) {
+        fields[FIELD_SEQUENCES + i] = stats->sequences[i];
+        fields[FIELD_SEQUENCE_BYTES + i] = stats->sequence_bytes[i];
+    }
+    fields[FIELD_TEXT] = stats->text_bytes;
+    fields[FIELD_FLUSHES] = stats->flushes;
+    fields[FIELD_SYSCALLS] = stats->syscalls;
+    fields[FIELD_FRAMES] = stats->frames;
+}
+
+
+static void stats_from_fields(const uint64_t *fields, t_color_stats *stats) {
+    for (int i = 0; i < NB_STATS_CATEGORIES; i++) {
+        stats->sequences[i] = fields[FIELD_SEQUENCES + i];
+        stats->sequence_bytes[i] = fields[FIELD_SEQUENCE_BYTES + i];
+    }
+    stats->text_bytes = fields[FIELD_TEXT];
+    stats->flushes = fields[FIELD_FLUSHES];
+    stats->syscalls = fields[FIELD_SYSCALLS];
+    stats->frames = fields[FIELD_FRAMES];
+}
+
+
+void color_stats_add(const t_color_stats *delta) {
+    t_stats_block *block = stats_block();
+    uint64_t fields[NB_FIELDS];
+
+    if (!block || !delta) return;
+
+    stats_to_fields(delta, fields);
+    for (int i = 0; i < NB_FIELDS; i++) {
+        if (fields[i]) stats_bump(block, i, fields[i]);
+    }
+}
+
+
+/* Sum of every thread since startup, lock held */
+static void stats_total(uint64_t *fields) {
+    memcpy(fields, g_stats_retired, sizeof(g_stats_retired));
+    for (const t_stats_block *block = g_stats_blocks; block; block = block->next) {
+        for (int i = 0; i < NB_FIELDS; i++) {
+            fields[i] += atomic_load_explicit(&block->fields[i], memory_order_relaxed);
+        }
+    }
+}
+
+
+void color_stats_snapshot(t_color_stats *out) {
+    uint64_t fields[NB_FIELDS];
+
+    if (!out) return;
+
+    pthread_mutex_lock(&g_stats_lock);
+    stats_total(fields);
+    for (int i = 0; i < NB_FIELDS; i++) fields[i] -= g_stats_base[i];
+    pthread_mutex_unlock(&g_stats_lock);
+
+    stats_from_fields(fields, out);
+}
+
+
+/* Blocks are never written by another thread, a reset moves the baseline instead */
+void color_stats_reset(void) {
+    pthread_mutex_lock(&g_stats_lock);
+    stats_total(g_stats_base);
+    pthread_mutex_unlock(&g_stats_lock);
+}
+
+
+/* --- Buffer classification --- */
+
+static unsigned stats_sgr_param(const char *params, size_t len, size_t *i) {
+    unsigned v = 0;
+
+    for (; *i < len && params[*i] >= '0' && params[*i] <= '9'; (*i)++) {
+        if (v < 65536) v = v * 10 + (unsigned)(params[*i] - '0');
+    }
+    return v;
+}
+
+
+/* Rank of a category when a sequence holds several: TrueColor, 8-bit, 4-bit, then Style */
+static int stats_sgr_rank(StatsCategory category) {
+    switch (category) {
+    case STATS_COLOR24: return 3;
+    case STATS_COLOR8: return 2;
+    case STATS_FORE: case STATS_BACK: return 1;
+    default: return 0;
+    }
+}
+
+
+/* One category per sequence: the highest ranked parameter group ("1;31" is Fore, "0;38;2;..." TrueColor) */
+static StatsCategory classify_sgr(const char *params, size_t len) {
+    StatsCategory best = STATS_STYLE;
+    size_t i = 0;
+
+    while (i < len) {
+        unsigned v = stats_sgr_param(params, len, &i);
+        char sep = (i < len) ? params[i++] : 0;
+        StatsCategory category = STATS_STYLE;
+
+        if ((v >= 30 && v <= 37) || v == 39 || (v >= 90 && v <= 97)) category = STATS_FORE;
+        else if ((v >= 40 && v <= 47) || v == 49 || (v >= 100 && v <= 107)) category = STATS_BACK;
+        else if (v == 38 || v == 48 || v == 58) {
+            size_t j = i;
+            unsigned mode = stats_sgr_param(params, len, &j);
+
+            if (j > i && (mode == 5 || mode == 2)) {
+                category = (mode == 5) ? STATS_COLOR8 : STATS_COLOR24;
+                /* Skip the color: up to the next ';' for colon sub-parameters, else mode + index or r;g;b */
+                size_t skip = (sep == ':') ? 1 : (mode == 5) ? 2 : 4;
+                for (; i < len && skip > 0; i++) {
+                    if (params[i] == ';') skip--;
+                }
+            }
+        }
+        if (stats_sgr_rank(category) > stats_sgr_rank(best)) best = category;
+    }
+    return best;
+}
+
+
+static StatsCategory classify_csi(const char *body, size_t len) {
+    char final = body[len - 1];
+    char marker = (len > 1 && body[0] >= '<' && body[0] <= '?') ? body[0] : 0;
+
+    if (marker == '?') {
+        /* DECTCEM only, other private modes (alternate screen, mouse...) are not cursor output */
+        if ((final == 'h' || final == 'l') && len == 4 && body[1] == '2' && body[2] == '5') return STATS_CURSOR;
+        return STATS_OTHER;
+    }
+    if (marker) return STATS_OTHER;
+
+    switch (final) {
+    case 'm':
+        return classify_sgr(body, len - 1);
+    case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G': case 'H': case 'f':
+    case 'n': case 's': case 'u':
+        return STATS_CURSOR;
+    case 'J': case 'K':
+        return STATS_SCREEN;
+    default:
+        return STATS_OTHER;
+    }
+}
+
+
+/* Length of a string sequence body (OSC, DCS...) up to and including BEL or ST */
+static size_t string_end(const char *buf, size_t len, const char *esc, size_t esc_len) {
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] == '\a') return i + 1;
+        if (i + esc_len < len && memcmp(buf + i, esc, esc_len) == 0 && buf[i + esc_len] == '\\') {
+            return i + esc_len + 1;
+        }
+    }
+    return len;
+}
+
+
+void color_stats_scan(const char *buf, size_t len) {
+    t_stats_block *block = stats_block();
+    const char *esc = get_ansi_esc_char();
+    size_t esc_len = get_ansi_esc_len();
+    size_t pos = 0;
+
+    if (!block || !buf || esc_len == 0) return;
+
+    while (pos < len) {
+        const char *hit = memchr(buf + pos, esc[0], len - pos);
+        size_t start = hit ? (size_t)(hit - buf) : len;
+
+        if (start > pos) stats_bump(block, FIELD_TEXT, start - pos);
+        pos = start;
+        if (pos >= len) break;
+
+        if (len - pos <= esc_len || memcmp(buf + pos, esc, esc_len) != 0) {
+            stats_bump(block, FIELD_TEXT, 1);
+            pos++;
+            continue;
+        }
+
+        const char *body = buf + pos + esc_len + 1;
+        size_t avail = len - pos - esc_len - 1;
+        size_t body_len = 0;
+        StatsCategory category = STATS_OTHER;
+
+        switch (buf[pos + esc_len]) {
+        case '[':
+            /* Parameter and intermediate bytes, and C0 controls (executed, they do not end the
+               sequence); ESC, CAN and SUB cancel it and are read again */
+            while (body_len < avail) {
+                unsigned char c = (unsigned char)body[body_len];
+                if (c == 0x1B || c == 0x18 || c == 0x1A || c >= 0x40) break;
+                body_len++;
+            }
+            if (body_len < avail && (unsigned char)body[body_len] >= 0x40 && (unsigned char)body[body_len] <= 0x7E) {
+                body_len++;
+                category = classify_csi(body, body_len);
+            }
+            break;
+        case ']': case 'P': case '_': case '^': case 'X':
+            body_len = string_end(body, avail, esc, esc_len);
+            break;
+        default:
+            break;
+        }
+
+        size_t seq_len = esc_len + 1 + body_len;
+        stats_bump(block, FIELD_SEQUENCES + category, 1);
+        stats_bump(block, FIELD_SEQUENCE_BYTES + category, seq_len);
+        pos += seq_len;
+    }
+}
+
+
+ssize_t color_stats_write(int fd, const char *buf, size_t len) {
+    size_t done = 0;
+    size_t syscalls = 0;
+
+    color_stats_scan(buf, len);
+
+    while (done < len) {
+        ssize_t n = write(fd, buf + done, len - done);
+        syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            color_stats_flush(syscalls);
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    color_stats_flush(syscalls);
+    return (ssize_t)done;
+}
+
+
+/* --- Reports --- */
+
+size_t color_stats_format(const t_color_stats *stats, char *dst, size_t size) {
+    uint64_t escapes = 0;
+    size_t len = 0;
+    int n;
+
+    if (!stats || !dst || size == 0) return 0;
+
+    for (int i = 0; i < NB_STATS_CATEGORIES; i++) escapes += stats->sequence_bytes[i];
+    uint64_t total = escapes + stats->text_bytes;
+
+    n = snprintf(dst, size,
+                 "color_stats: %llu bytes, text %llu, escapes %llu (%.1f%%), %llu flushes, %llu syscalls, %llu frames\n",
+                 (unsigned long long)total, (unsigned long long)stats->text_bytes, (unsigned long long)escapes,
+                 total ? 100.0 * (double)escapes / (double)total : 0.0,
+                 (unsigned long long)stats->flushes, (unsigned long long)stats->syscalls,
+                 (unsigned long long)stats->frames);
+    len += (n > 0) ? (size_t)n : 0;
+
+    for (int i = 0; i < NB_STATS_CATEGORIES && len < size; i++) {
+        if (!stats->sequences[i]) continue;
+        n = snprintf(dst + len, size - len, "  %-8s %10llu seq %12llu bytes\n", STATS_CATEGORY_NAMES[i],
+                     (unsigned long long)stats->sequences[i], (unsigned long long)stats->sequence_bytes[i]);
+        len += (n > 0) ? (size_t)n : 0;
+    }
+
+    if (stats->frames && len < size) {
+        double frames = (double)stats->frames;
+        n = snprintf(dst + len, size - len, "  per frame: %.1f bytes, %.2f flushes, %.2f syscalls\n",
+                     (double)total / frames, (double)stats->flushes / frames, (double)stats->syscalls / frames);
+        len += (n > 0) ? (size_t)n : 0;
+    }
+
+    return (len < size) ? len : size - 1;
+}
+
+
+int color_stats_dump(int fd) {
+    t_color_stats stats;
+    char report[STATS_REPORT_MAX];
+
+    color_stats_snapshot(&stats);
+    size_t len = color_stats_format(&stats, report, sizeof(report));
+
+    /* Plain write: the report itself is not accounted */
+    for (size_t done = 0; done < len;) {
+        ssize_t n = write(fd, report + done, len - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        done += (size_t)n;
+    }
+    return 1;
+}
+
+
+static void *stats_dump_loop(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_stats_dump_lock);
+    while (g_stats_dump_interval) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += g_stats_dump_interval / 1000;
+        deadline.tv_nsec += (long)(g_stats_dump_interval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+
+        /* A signal means the settings changed: start a new period */
+        int ret = pthread_cond_timedwait(&g_stats_dump_cond, &g_stats_dump_lock, &deadline);
+        if (ret == ETIMEDOUT && g_stats_dump_interval) {
+            int fd = g_stats_dump_fd;
+            pthread_mutex_unlock(&g_stats_dump_lock);
+            color_stats_dump(fd);
+            pthread_mutex_lock(&g_stats_dump_lock);
+        }
+    }
+    g_stats_dump_running = 0;
+    pthread_mutex_unlock(&g_stats_dump_lock);
+    return NULL;
+}
+
+
+int color_stats_dump_every(int fd, unsigned interval_ms) {
+    int ok = 1;
+
+    pthread_mutex_lock(&g_stats_dump_lock);
+    g_stats_dump_fd = fd;
+    g_stats_dump_interval = interval_ms;
+
+    if (interval_ms && !g_stats_dump_running) {
+        pthread_t thread;
+        pthread_attr_t attr;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        ok = (pthread_create(&thread, &attr, stats_dump_loop, NULL) == 0);
+        pthread_attr_destroy(&attr);
+        g_stats_dump_running = ok;
+    }
+    pthread_cond_signal(&g_stats_dump_cond);
+    pthread_mutex_unlock(&g_stats_dump_lock);
+
+    return ok;
+}
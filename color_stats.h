@@ -0,0 +1,135 @@
+/**
+ * @file color_stats.h
+ * @brief Opt-in output accounting: escape bytes per category, text bytes, flushes, syscalls.
+ *
+ * Counters live in per-thread blocks that only their owner writes; color_stats_snapshot()
+ * sums the blocks of live and exited threads on demand. While disabled (the default)
+ * every recording call returns after one load.
+ *
+ * The library's own output paths record themselves: frame_write() (per sequence, per
+ * writev and per frame), log_write() and the sixel writers. Output printed by the
+ * application (e.g. Fore.RED through printf) is accounted by passing the buffer to
+ * color_stats_scan(), or by writing it with color_stats_write().
+ */
+
+#ifndef COLOR_STATS_H
+#define COLOR_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sequence categories, following the library tables and generators.
+ */
+typedef enum {
+    STATS_FORE    = 0, ///< 4-bit foreground (Fore table, SGR 30-39 / 90-97)
+    STATS_BACK    = 1, ///< 4-bit background (Back table, SGR 40-49 / 100-107)
+    STATS_STYLE   = 2, ///< Other SGR (Style table, resets, underline color...)
+    STATS_CURSOR  = 3, ///< Cursor motion, save/restore, visibility, DSR
+    STATS_SCREEN  = 4, ///< Erasing (ED, EL)
+    STATS_COLOR8  = 5, ///< 8-bit colors (38;5 / 48;5 / 58;5)
+    STATS_COLOR24 = 6, ///< TrueColor (38;2 / 48;2 / 58;2)
+    STATS_OTHER   = 7  ///< Anything else (OSC, DCS/sixel, private modes...)
+} StatsCategory;
+
+#define NB_STATS_CATEGORIES 8
+
+/**
+ * @brief Aggregated counters.
+ */
+typedef struct s_color_stats {
+    uint64_t sequences[NB_STATS_CATEGORIES];      /**< Sequences per category */
+    uint64_t sequence_bytes[NB_STATS_CATEGORIES]; /**< Escape bytes per category */
+    uint64_t text_bytes;                          /**< Printed text, escapes excluded */
+    uint64_t flushes;                             /**< Buffers handed to the kernel */
+    uint64_t syscalls;                            /**< write() / writev() calls */
+    uint64_t frames;                              /**< Frames marked with color_stats_frame() */
+} t_color_stats;
+
+/**
+ * @brief Turns recording on or off (default off).
+ */
+void color_stats_enable(int enabled);
+
+/**
+ * @brief Tells whether recording is on, so callers can skip their own counting.
+ */
+int color_stats_enabled(void);
+
+/**
+ * @brief Records one sequence of 'len' bytes.
+ */
+void color_stats_sequence(StatsCategory category, size_t len);
+
+/**
+ * @brief Records 'len' bytes of text.
+ */
+void color_stats_text(size_t len);
+
+/**
+ * @brief Records a flush made of 'syscalls' write calls.
+ */
+void color_stats_flush(size_t syscalls);
+
+/**
+ * @brief Marks the end of a frame.
+ */
+void color_stats_frame(void);
+
+/**
+ * @brief Adds a whole batch of counts at once (encoders count locally, then record once).
+ */
+void color_stats_add(const t_color_stats *delta);
+
+/**
+ * @brief Classifies every sequence of an output buffer and counts the text around them.
+ * * Sequences are expected to be complete within the buffer. An SGR setting several
+ * attributes counts once, under its highest ranked group: TrueColor, 8-bit, 4-bit
+ * (the first of Fore / Back), then Style. "1;31" is Fore, "0;38;2;r;g;b" TrueColor.
+ */
+void color_stats_scan(const char *buf, size_t len);
+
+/**
+ * @brief Writes a buffer entirely, accounting its content, the flush and each write() call.
+ * @return Number of bytes written, or -1 on error.
+ */
+ssize_t color_stats_write(int fd, const char *buf, size_t len);
+
+/**
+ * @brief Sums the counters of every thread since the last reset.
+ */
+void color_stats_snapshot(t_color_stats *out);
+
+/**
+ * @brief Restarts every counter from zero.
+ */
+void color_stats_reset(void);
+
+/**
+ * @brief Formats a snapshot as a short text report.
+ * @return Number of bytes written (NUL excluded), truncated to fit.
+ */
+size_t color_stats_format(const t_color_stats *stats, char *dst, size_t size);
+
+/**
+ * @brief Writes the current report to fd.
+ * @return 1 on success, 0 on write error.
+ */
+int color_stats_dump(int fd);
+
+/**
+ * @brief Dumps the report to fd every interval_ms from a background thread (0 stops it).
+ * @return 1 on success, 0 if the thread could not be started.
+ */
+int color_stats_dump_every(int fd, unsigned interval_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_STATS_H */
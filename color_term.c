@@ -0,0 +1,299 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_term.h"
+
+
+#define TERM_QUERY_MAX 128
+
+
+enum {
+    PARSE_GROUND = 0,
+    PARSE_ESC    = 1,
+    PARSE_CSI    = 2
+};
+
+
+static volatile sig_atomic_t g_term_resized = 1;
+static _Atomic uint64_t g_term_size_cache;
+static atomic_int g_term_size_fd = -1;
+static atomic_flag g_term_winch_installed = ATOMIC_FLAG_INIT;
+static struct sigaction g_term_prev_winch;
+
+
+void term_parser_init(t_term_parser *parser) {
+    memset(parser, 0, sizeof(t_term_parser));
+}
+
+
+static TermReplyKind reply_kind(const t_term_reply *reply) {
+    const uint16_t *p = reply->params;
+
+    if (reply->final == 'R' && reply->nb_params >= 2 && (reply->marker == 0 || reply->marker == '?')) {
+        return TERM_REPLY_CURSOR;
+    }
+    if (reply->final == 't' && reply->marker == 0 && reply->nb_params == 3) {
+        if (p[0] == 8) return TERM_REPLY_SIZE_CELLS;
+        if (p[0] == 4) return TERM_REPLY_SIZE_PIXELS;
+    }
+    if (reply->final == 'c' && reply->marker == '?') return TERM_REPLY_DEVICE_ATTRS;
+    return TERM_REPLY_OTHER;
+}
+
+
+size_t term_parser_feed(t_term_parser *parser, const char *data, size_t len, t_term_reply *reply) {
+    t_term_reply *cur = &parser->reply;
+
+    reply->kind = TERM_REPLY_NONE;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)data[i];
+
+        switch (parser->state) {
+        case PARSE_GROUND:
+            if (c == 0x1B) {
+                parser->state = PARSE_ESC;
+            } else if (c == 0x9B) {
+                memset(cur, 0, sizeof(t_term_reply));
+                parser->state = PARSE_CSI;
+            }
+            break;
+
+        case PARSE_ESC:
+            if (c == '[') {
+                memset(cur, 0, sizeof(t_term_reply));
+                parser->state = PARSE_CSI;
+            } else if (c != 0x1B) {
+                parser->state = PARSE_GROUND;
+            }
+            break;
+
+        case PARSE_CSI:
+            if (c >= '0' && c <= '9') {
+                if (cur->nb_params == 0) cur->nb_params = 1;
+                uint16_t *p = &cur->params[cur->nb_params - 1];
+                *p = (*p > 6553) ? UINT16_MAX : (uint16_t)(*p * 10 + (c - '0'));
+            } else if (c == ';' || c == ':') {
+                if (cur->nb_params == 0) cur->nb_params = 1;
+                if (cur->nb_params < TERM_REPLY_MAX_PARAMS) cur->nb_params++;
+            } else if (c >= '<' && c <= '?') {
+                cur->marker = (char)c;
+            } else if (c >= 0x40 && c <= 0x7E) {
+                cur->final = (char)c;
+                cur->kind = reply_kind(cur);
+                *reply = *cur;
+                parser->state = PARSE_GROUND;
+                return i + 1;
+            } else if (c == 0x1B) {
+                parser->state = PARSE_ESC;
+            } else if (c < 0x20 || c > 0x2F) {
+                /* Not a reply (intermediates 0x20..0x2F are skipped) */
+                parser->state = PARSE_GROUND;
+            }
+            break;
+        }
+    }
+    return len;
+}
+
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+static int write_query(int fd, const char *query, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, query, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        query += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+
+/* Reads one byte at a time so input following the reply stays in the terminal queue */
+static int wait_reply(int in_fd, TermReplyKind kind, t_term_reply *reply, int timeout_ms) {
+    t_term_parser parser;
+    int64_t deadline = monotonic_ms() + timeout_ms;
+
+    term_parser_init(&parser);
+    for (;;) {
+        int64_t left = deadline - monotonic_ms();
+        if (left <= 0) {
+            errno = ETIMEDOUT;
+            return 0;
+        }
+
+        struct pollfd pfd = {in_fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, (int)left);
+        if (ready < 0 && errno != EINTR) return 0;
+        if (ready <= 0) continue;
+
+        char c;
+        ssize_t n = read(in_fd, &c, 1);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+        if (n <= 0) return 0;
+
+        term_parser_feed(&parser, &c, 1, reply);
+        if (reply->kind == kind) return 1;
+    }
+}
+
+
+int term_query_n(int in_fd, int out_fd, const char *query, size_t len, TermReplyKind kind, t_term_reply *reply, int timeout_ms) {
+    struct termios saved;
+
+    if (!query || !reply) return 0;
+
+    int raw = (tcgetattr(in_fd, &saved) == 0);
+
+    if (raw) {
+        struct termios t = saved;
+        t.c_lflag &= ~(ICANON | ECHO);
+        t.c_cc[VMIN] = 1;
+        t.c_cc[VTIME] = 0;
+        tcsetattr(in_fd, TCSANOW, &t);
+    }
+
+    int ok = write_query(out_fd, query, len) && wait_reply(in_fd, kind, reply, timeout_ms);
+
+    if (raw) {
+        int err = errno;
+        tcsetattr(in_fd, TCSANOW, &saved);
+        errno = err;
+    }
+    return ok;
+}
+
+
+int term_query(int in_fd, int out_fd, const char *query, TermReplyKind kind, t_term_reply *reply, int timeout_ms) {
+    if (!query) return 0;
+
+    return term_query_n(in_fd, out_fd, query, strlen(query), kind, reply, timeout_ms);
+}
+
+
+/* Built from the escape prefix: init_color() with flags 0 changes it without rebuilding the Cursor table */
+int term_cursor_pos(int in_fd, int out_fd, t_cursor_pos *pos, int timeout_ms) {
+    char query[TERM_QUERY_MAX];
+    t_term_reply reply;
+
+    if (!pos) return 0;
+
+    int len = snprintf(query, sizeof(query), "%s[6n", get_ansi_esc_char());
+    if (!term_query_n(in_fd, out_fd, query, len, TERM_REPLY_CURSOR, &reply, timeout_ms)) return 0;
+
+    pos->row = reply.params[0];
+    pos->col = reply.params[1];
+    return 1;
+}
+
+
+int term_query_size(int in_fd, int out_fd, t_term_size *size, int timeout_ms) {
+    char query[TERM_QUERY_MAX];
+    t_term_reply reply;
+
+    if (!size) return 0;
+
+    /* DECSC, move past the margins (clamped to the last row and column), DSR 6, DECRC */
+    const char *esc = get_ansi_esc_char();
+    int len = snprintf(query, sizeof(query), "%s7%s[9999;9999H%s[6n%s8", esc, esc, esc, esc);
+    if (!term_query_n(in_fd, out_fd, query, len, TERM_REPLY_CURSOR, &reply, timeout_ms)) return 0;
+
+    size->rows = reply.params[0];
+    size->cols = reply.params[1];
+    size->width_px = 0;
+    size->height_px = 0;
+    return 1;
+}
+
+
+static void on_winch(int sig, siginfo_t *info, void *context) {
+    g_term_resized = 1;
+
+    /* Chain to the handler installed before ours */
+    if (g_term_prev_winch.sa_flags & SA_SIGINFO) {
+        if (g_term_prev_winch.sa_sigaction) g_term_prev_winch.sa_sigaction(sig, info, context);
+    } else if (g_term_prev_winch.sa_handler != SIG_DFL && g_term_prev_winch.sa_handler != SIG_IGN) {
+        g_term_prev_winch.sa_handler(sig);
+    }
+}
+
+
+static void install_winch(void) {
+    if (atomic_flag_test_and_set(&g_term_winch_installed)) return;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = on_winch;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGWINCH, &sa, &g_term_prev_winch);
+}
+
+
+static uint64_t pack_size(const t_term_size *s) {
+    return (uint64_t)s->rows << 48 | (uint64_t)s->cols << 32 | (uint64_t)s->width_px << 16 | s->height_px;
+}
+
+
+static void unpack_size(uint64_t v, t_term_size *s) {
+    s->rows = (uint16_t)(v >> 48);
+    s->cols = (uint16_t)(v >> 32);
+    s->width_px = (uint16_t)(v >> 16);
+    s->height_px = (uint16_t)v;
+}
+
+
+int term_size(int fd, t_term_size *size) {
+    if (!size) return 0;
+
+    if (!g_term_resized && atomic_load_explicit(&g_term_size_fd, memory_order_acquire) == fd) {
+        unpack_size(atomic_load_explicit(&g_term_size_cache, memory_order_relaxed), size);
+        return 1;
+    }
+
+    install_winch();
+
+    /* Cleared before the ioctl, a resize during it triggers another refresh */
+    g_term_resized = 0;
+
+    struct winsize ws;
+    if (ioctl(fd, TIOCGWINSZ, &ws) < 0) {
+        g_term_resized = 1;
+        return 0;
+    }
+
+    size->rows = ws.ws_row;
+    size->cols = ws.ws_col;
+    size->width_px = ws.ws_xpixel;
+    size->height_px = ws.ws_ypixel;
+
+    atomic_store_explicit(&g_term_size_cache, pack_size(size), memory_order_relaxed);
+    atomic_store_explicit(&g_term_size_fd, fd, memory_order_release);
+    return 1;
+}
+
+
+void term_size_invalidate(void) {
+    g_term_resized = 1;
+}
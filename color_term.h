@@ -0,0 +1,125 @@
+/**
+ * @file color_term.h
+ * @brief Terminal queries: cursor position and size replies read with a timeout, cached window size.
+ *
+ * Replies to DSR and window reports are decoded by a small incremental parser, usable on
+ * its own from an event loop (feed it whatever input arrives) or through term_query(),
+ * which writes the query, switches the input to non-canonical mode and polls with a
+ * deadline. Keystrokes read while waiting for a reply are discarded.
+ *
+ * term_size() caches TIOCGWINSZ. A SIGWINCH handler (chained to any previous one)
+ * only raises a flag, so the next call refreshes; every other call is a plain atomic load.
+ */
+
+#ifndef COLOR_TERM_H
+#define COLOR_TERM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TERM_REPLY_MAX_PARAMS 16
+
+/**
+ * @brief Terminal size in cells, and in pixels when the terminal reports it (0 otherwise).
+ */
+typedef struct s_term_size {
+    uint16_t rows;
+    uint16_t cols;
+    uint16_t width_px;
+    uint16_t height_px;
+} t_term_size;
+
+/**
+ * @brief Kind of a decoded reply.
+ */
+typedef enum {
+    TERM_REPLY_NONE         = 0, ///< No complete reply yet
+    TERM_REPLY_CURSOR       = 1, ///< CSI row ; col R (DSR 6), params[0] = row, params[1] = col
+    TERM_REPLY_SIZE_CELLS   = 2, ///< CSI 8 ; rows ; cols t (XTWINOPS 18)
+    TERM_REPLY_SIZE_PIXELS  = 3, ///< CSI 4 ; height ; width t (XTWINOPS 14)
+    TERM_REPLY_DEVICE_ATTRS = 4, ///< CSI ? ... c (DA1)
+    TERM_REPLY_OTHER        = 5  ///< Any other complete CSI sequence
+} TermReplyKind;
+
+/**
+ * @brief Decoded CSI reply.
+ */
+typedef struct s_term_reply {
+    TermReplyKind kind;
+    char marker;       ///< Private marker ('?', '>', '<', '=') or 0
+    char final;        ///< Final byte
+    uint8_t nb_params;
+    uint16_t params[TERM_REPLY_MAX_PARAMS];
+} t_term_reply;
+
+/**
+ * @brief Incremental reply parser, accepts 7-bit (ESC [) and 8-bit (0x9B) CSI.
+ */
+typedef struct s_term_parser {
+    uint8_t state;
+    t_term_reply reply;
+} t_term_parser;
+
+/**
+ * @brief Resets a parser.
+ */
+void term_parser_init(t_term_parser *parser);
+
+/**
+ * @brief Feeds input to the parser, stopping right after the first complete CSI sequence.
+ * @param reply Receives the sequence; reply->kind is TERM_REPLY_NONE if none completed.
+ * @return Number of bytes consumed (feed the rest again to get the next sequence).
+ */
+size_t term_parser_feed(t_term_parser *parser, const char *data, size_t len, t_term_reply *reply);
+
+/**
+ * @brief Writes a query and waits for a reply of the given kind.
+ * * When in_fd is a terminal it is switched to non-canonical, no-echo mode for the
+ * duration of the call, then restored.
+ * @param timeout_ms Maximum wait for the reply.
+ * @return 1 on success, 0 on timeout (errno = ETIMEDOUT) or I/O error.
+ */
+int term_query(int in_fd, int out_fd, const char *query, TermReplyKind kind, t_term_reply *reply, int timeout_ms);
+
+/**
+ * @brief term_query() with the query length given, e.g. from COLOR_LEN() or a put_* encoder.
+ */
+int term_query_n(int in_fd, int out_fd, const char *query, size_t len, TermReplyKind kind, t_term_reply *reply, int timeout_ms);
+
+/**
+ * @brief Gets the cursor position through DSR 6.
+ * @return 1 on success, 0 on timeout or error.
+ */
+int term_cursor_pos(int in_fd, int out_fd, t_cursor_pos *pos, int timeout_ms);
+
+/**
+ * @brief Measures the terminal size through the terminal itself (cursor pushed to the
+ * bottom-right corner then DSR 6), for lines where TIOCGWINSZ is not available.
+ * * The cursor position is saved and restored.
+ * @return 1 on success, 0 on timeout or error.
+ */
+int term_query_size(int in_fd, int out_fd, t_term_size *size, int timeout_ms);
+
+/**
+ * @brief Gets the terminal size of fd, from the cache unless SIGWINCH was received.
+ * * The first call installs the SIGWINCH handler.
+ * @return 1 on success, 0 if fd is not a terminal.
+ */
+int term_size(int fd, t_term_size *size);
+
+/**
+ * @brief Forces the next term_size() call to query the terminal.
+ */
+void term_size_invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_TERM_H */
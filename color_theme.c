@@ -0,0 +1,530 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_parse.h"
+#include "color_theme.h"
+
+
+#define THEME_SEQ_SIZE 256
+#define THEME_WORD_SIZE 64
+
+
+/* Style being compiled, before it is laid out in the blob */
+typedef struct s_theme_style {
+    uint32_t hash;
+    uint16_t name_len;
+    uint16_t seq_len;
+    char name[THEME_NAME_MAX];
+    char seq[THEME_SEQ_SIZE];
+} t_theme_style;
+
+
+typedef struct s_theme_word {
+    const char *word;
+    uint8_t code;
+} t_theme_word;
+
+
+static const t_theme_word THEME_WORDS[] = {
+    {"reset", 0},
+    {"bold", 1},
+    {"dim", 2},
+    {"italic", 3},
+    {"underline", 4},
+    {"blink", 5},
+    {"reverse", 7},
+    {"hidden", 8},
+    {"strikethrough", 9},
+    {"double_underline", 21}
+};
+
+#define NB_THEME_WORDS (sizeof(THEME_WORDS) / sizeof(THEME_WORDS[0]))
+
+
+static uint32_t theme_hash32(const void *data, size_t len, uint32_t h) {
+    const unsigned char *p = data;
+
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x01000193u;
+    }
+    return h;
+}
+
+
+static uint64_t theme_hash64(const void *data, size_t len) {
+    const unsigned char *p = data;
+    uint64_t h = 0xCBF29CE484222325ull;
+
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 0x100000001B3ull;
+    }
+    return h;
+}
+
+
+/* Sequences depend on the escape prefix and the depth they were rendered with */
+static uint32_t render_hash(GradientDepth depth) {
+    uint8_t d = (uint8_t)depth;
+    uint32_t h = theme_hash32(get_ansi_esc_char(), get_ansi_esc_len(), 0x811C9DC5u);
+
+    return theme_hash32(&d, 1, h);
+}
+
+
+static uint64_t mtime_ns(const struct stat *st) {
+    return (uint64_t)st->st_mtim.tv_sec * 1000000000ull + (uint64_t)st->st_mtim.tv_nsec;
+}
+
+
+static char *read_source(const char *path, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {close(fd);return NULL;}
+
+    size_t size = (size_t)st.st_size;
+    char *buf = malloc(size + 1);
+    size_t done = 0;
+
+    while (buf && done < size) {
+        ssize_t n = read(fd, buf + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    close(fd);
+
+    if (buf) {
+        buf[done] = '\0';
+        *len = done;
+    }
+    return buf;
+}
+
+
+static int write_file(int fd, const void *data, size_t len) {
+    const char *p = data;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+
+static int is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+
+/* Next word of a style, "rgb(1, 2, 3)" stays in one piece */
+static const char *next_word(const char *p, const char *end, const char **word_end) {
+    while (p < end && is_space(*p)) p++;
+    if (p == end) return NULL;
+
+    const char *q = p;
+    int depth = 0;
+    while (q < end && (depth > 0 || !is_space(*q))) {
+        if (*q == '(') depth++;
+        else if (*q == ')' && depth > 0) depth--;
+        q++;
+    }
+    *word_end = q;
+    return p;
+}
+
+
+static size_t put_sgr(char *dst, uint8_t code) {
+    char *p = dst;
+    size_t esc_len = get_ansi_esc_len();
+
+    memcpy(p, get_ansi_esc_char(), esc_len);
+    p += esc_len;
+    *p++ = '[';
+    if (code >= 100) *p++ = '0' + code / 100;
+    if (code >= 10) *p++ = '0' + (code / 10) % 10;
+    *p++ = '0' + code % 10;
+    *p++ = 'm';
+    return p - dst;
+}
+
+
+static size_t put_color(char *dst, const char *spec, size_t len, ColorLayer layer, GradientDepth depth) {
+    char word[THEME_WORD_SIZE];
+    t_rgb c;
+
+    if (len >= THEME_WORD_SIZE) return 0;
+    memcpy(word, spec, len);
+    word[len] = '\0';
+
+    if (depth == GRADIENT_DEPTH_8) {
+        uint8_t index;
+        if (!color_parse8(word, &index)) return 0;
+        return put_color8(dst, layer, index);
+    }
+    if (!color_parse(word, &c)) return 0;
+    return put_color24(dst, layer, c.r, c.g, c.b);
+}
+
+
+/* Renders the words of one style, 0 on unknown word or overflow */
+static int render_style(t_theme_style *style, const char *p, const char *end, GradientDepth depth) {
+    const char *word_end;
+    ColorLayer layer = COLOR_LAYER_FORE;
+    size_t len = 0;
+
+    while ((p = next_word(p, end, &word_end)) != NULL) {
+        size_t n = word_end - p;
+        size_t written = 0;
+
+        if (len + COLOR_SEQ_MAX >= THEME_SEQ_SIZE) return 0;
+
+        if (n == 2 && memcmp(p, "on", 2) == 0) {
+            layer = COLOR_LAYER_BACK;
+            p = word_end;
+            continue;
+        }
+        if (layer == COLOR_LAYER_FORE) {
+            for (size_t i = 0; i < NB_THEME_WORDS; i++) {
+                if (strlen(THEME_WORDS[i].word) == n && memcmp(THEME_WORDS[i].word, p, n) == 0) {
+                    written = put_sgr(style->seq + len, THEME_WORDS[i].code);
+                    break;
+                }
+            }
+        }
+        if (!written) written = put_color(style->seq + len, p, n, layer, depth);
+        if (!written) return 0;
+
+        len += written;
+        layer = COLOR_LAYER_FORE;
+        p = word_end;
+    }
+    if (layer != COLOR_LAYER_FORE) return 0;
+
+    style->seq[len] = '\0';
+    style->seq_len = (uint16_t)len;
+    return 1;
+}
+
+
+static int compare_styles(const void *a, const void *b) {
+    uint32_t ha = ((const t_theme_style *)a)->hash;
+    uint32_t hb = ((const t_theme_style *)b)->hash;
+
+    return (ha > hb) - (ha < hb);
+}
+
+
+/* Parses the source into styles (later definitions override earlier ones), NULL on syntax error */
+static t_theme_style *parse_source(const char *src, size_t size, GradientDepth depth, size_t *count) {
+    t_theme_style *styles = NULL;
+    size_t nb = 0, cap = 0;
+    const char *line = src;
+    const char *end = src + size;
+
+    while (line < end) {
+        const char *eol = memchr(line, '\n', end - line);
+        if (!eol) eol = end;
+
+        const char *p = line;
+        const char *q = eol;
+        line = (eol < end) ? eol + 1 : end;
+
+        while (p < q && is_space(*p)) p++;
+        if (p == q || *p == ';' || (*p == '#' && (p + 1 == q || is_space(p[1])))) continue;
+
+        const char *eq = memchr(p, '=', q - p);
+        if (!eq) goto syntax_error;
+
+        const char *name_end = eq;
+        while (name_end > p && is_space(name_end[-1])) name_end--;
+        size_t name_len = name_end - p;
+        if (name_len == 0 || name_len >= THEME_NAME_MAX) goto syntax_error;
+
+        t_theme_style *style = NULL;
+        uint32_t hash = theme_hash32(p, name_len, 0x811C9DC5u);
+        for (size_t i = 0; i < nb && !style; i++) {
+            if (styles[i].hash == hash && styles[i].name_len == name_len && memcmp(styles[i].name, p, name_len) == 0) {
+                style = &styles[i];
+            }
+        }
+        if (!style) {
+            if (nb == cap) {
+                cap = (cap) ? cap * 2 : 32;
+                t_theme_style *grown = realloc(styles, cap * sizeof(t_theme_style));
+                if (!grown) goto syntax_error;
+                styles = grown;
+            }
+            style = &styles[nb++];
+            memcpy(style->name, p, name_len);
+            style->name[name_len] = '\0';
+            style->name_len = (uint16_t)name_len;
+            style->hash = hash;
+        }
+        if (!render_style(style, eq + 1, q, depth)) goto syntax_error;
+    }
+
+    *count = nb;
+    return (styles) ? styles : calloc(1, sizeof(t_theme_style));
+
+syntax_error:
+    free(styles);
+    errno = EINVAL;
+    return NULL;
+}
+
+
+static size_t put_pool_string(unsigned char *dst, const char *s, uint16_t len) {
+    memcpy(dst, &len, sizeof(len));
+    memcpy(dst + sizeof(len), s, len);
+    dst[sizeof(len) + len] = '\0';
+    return sizeof(len) + len + 1;
+}
+
+
+/* Write next to the cache then rename, readers never map a partial file */
+static int write_cache(const char *cache_path, const void *blob, size_t size) {
+    size_t path_len = strlen(cache_path);
+    char *tmp_path = malloc(path_len + 32);
+    int ok = 0;
+
+    if (!tmp_path) return 0;
+
+    snprintf(tmp_path, path_len + 32, "%s.%ld.tmp", cache_path, (long)getpid());
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        ok = write_file(fd, blob, size);
+        ok = (close(fd) == 0) && ok;
+        ok = ok && rename(tmp_path, cache_path) == 0;
+        if (!ok) unlink(tmp_path);
+    }
+    free(tmp_path);
+
+    return ok;
+}
+
+
+int theme_compile(const char *source_path, const char *cache_path, GradientDepth depth) {
+    struct stat st;
+    size_t src_len = 0, nb = 0;
+
+    if (!source_path || !cache_path || stat(source_path, &st) < 0) return 0;
+
+    char *src = read_source(source_path, &src_len);
+    if (!src) return 0;
+
+    t_theme_style *styles = parse_source(src, src_len, depth, &nb);
+    uint64_t src_hash = theme_hash64(src, src_len);
+    free(src);
+    if (!styles) return 0;
+
+    qsort(styles, nb, sizeof(t_theme_style), compare_styles);
+
+    size_t pool_offset = sizeof(t_theme_header) + nb * sizeof(t_theme_entry);
+    size_t total = pool_offset;
+    for (size_t i = 0; i < nb; i++) {
+        total += 2 * (sizeof(uint16_t) + 1) + styles[i].name_len + styles[i].seq_len;
+    }
+
+    unsigned char *blob = calloc(1, total);
+    if (!blob || total > UINT32_MAX) {free(blob);free(styles);return 0;}
+
+    t_theme_header *header = (t_theme_header *)blob;
+    t_theme_entry *entries = (t_theme_entry *)(blob + sizeof(t_theme_header));
+    size_t pos = 0;
+
+    for (size_t i = 0; i < nb; i++) {
+        entries[i].name_hash = styles[i].hash;
+        entries[i].name_offset = (uint32_t)pos;
+        pos += put_pool_string(blob + pool_offset + pos, styles[i].name, styles[i].name_len);
+        entries[i].seq_offset = (uint32_t)pos;
+        pos += put_pool_string(blob + pool_offset + pos, styles[i].seq, styles[i].seq_len);
+    }
+    free(styles);
+
+    memcpy(header->magic, THEME_MAGIC, sizeof(THEME_MAGIC));
+    header->version = THEME_VERSION;
+    header->nb_entries = (uint32_t)nb;
+    header->source_mtime_ns = mtime_ns(&st);
+    header->source_size = (uint64_t)src_len;
+    header->source_hash = src_hash;
+    header->render_hash = render_hash(depth);
+    header->pool_offset = (uint32_t)pool_offset;
+    header->total_size = (uint32_t)total;
+    header->checksum = theme_hash32(blob + sizeof(t_theme_header), total - sizeof(t_theme_header), 0x811C9DC5u);
+
+    int ok = write_cache(cache_path, blob, total);
+    free(blob);
+
+    return ok;
+}
+
+
+static const unsigned char *pool_string(const t_theme *theme, uint32_t offset, uint16_t *len) {
+    memcpy(len, theme->pool + offset, sizeof(*len));
+    return theme->pool + offset + sizeof(*len);
+}
+
+
+/* Every offset and length is checked once here, lookups then trust the blob. Sets theme->pool. */
+static int validate(t_theme *theme, GradientDepth depth) {
+    const t_theme_header *header = theme->header;
+    size_t size = theme->size;
+
+    if (memcmp(header->magic, THEME_MAGIC, sizeof(THEME_MAGIC)) != 0) return 0;
+    if (header->version != THEME_VERSION || header->total_size != size) return 0;
+    if (header->render_hash != render_hash(depth)) return 0;
+    if (header->nb_entries > (size - sizeof(t_theme_header)) / sizeof(t_theme_entry)) return 0;
+    if (header->pool_offset != sizeof(t_theme_header) + header->nb_entries * sizeof(t_theme_entry)) return 0;
+
+    uint32_t sum = theme_hash32(theme->map + sizeof(t_theme_header), size - sizeof(t_theme_header), 0x811C9DC5u);
+    if (sum != header->checksum) return 0;
+
+    theme->pool = theme->map + header->pool_offset;
+    size_t pool_size = size - header->pool_offset;
+    for (uint32_t i = 0; i < header->nb_entries; i++) {
+        uint32_t offsets[2] = {theme->entries[i].name_offset, theme->entries[i].seq_offset};
+
+        for (int k = 0; k < 2; k++) {
+            uint16_t len;
+            if (pool_size < sizeof(len) + 1 || offsets[k] > pool_size - sizeof(len) - 1) return 0;
+            const unsigned char *s = pool_string(theme, offsets[k], &len);
+            if (offsets[k] + sizeof(len) + len >= pool_size || s[len] != '\0') return 0;
+        }
+    }
+    return 1;
+}
+
+
+static t_theme *map_cache(const char *cache_path, GradientDepth depth) {
+    int fd = open(cache_path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(t_theme_header)) {close(fd);return NULL;}
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    t_theme *theme = malloc(sizeof(t_theme));
+    if (!theme) {munmap(map, (size_t)st.st_size);return NULL;}
+
+    theme->map = map;
+    theme->size = (size_t)st.st_size;
+    theme->header = map;
+    theme->entries = (const t_theme_entry *)(theme->map + sizeof(t_theme_header));
+    theme->pool = NULL;
+
+    if (!validate(theme, depth)) {
+        theme_close(theme);
+        return NULL;
+    }
+    return theme;
+}
+
+
+/*
+ * Same mtime and size: fresh. Touched but same content: fresh, and a copy with the new
+ * mtime replaces the cache (renamed over it, the mapping in use is never written to).
+ */
+static int is_fresh(const t_theme *theme, const char *source_path, const char *cache_path, const struct stat *st) {
+    const t_theme_header *header = theme->header;
+
+    if ((uint64_t)st->st_size != header->source_size) return 0;
+    if (mtime_ns(st) == header->source_mtime_ns) return 1;
+
+    size_t len = 0;
+    char *src = read_source(source_path, &len);
+    if (!src) return 0;
+
+    uint64_t hash = theme_hash64(src, len);
+    free(src);
+    if (hash != header->source_hash || len != header->source_size) return 0;
+
+    /* The checksum covers what follows the header, the copy stays valid */
+    unsigned char *copy = malloc(theme->size);
+    if (copy) {
+        uint64_t mtime = mtime_ns(st);
+        memcpy(copy, theme->map, theme->size);
+        memcpy(copy + offsetof(t_theme_header, source_mtime_ns), &mtime, sizeof(mtime));
+        write_cache(cache_path, copy, theme->size);
+        free(copy);
+    }
+    return 1;
+}
+
+
+t_theme *theme_load(const char *source_path, const char *cache_path, GradientDepth depth) {
+    struct stat st;
+
+    if (!cache_path) return NULL;
+
+    t_theme *theme = map_cache(cache_path, depth);
+
+    /* No source (shipped cache only): use the cache as is */
+    if (!source_path) return theme;
+    if (stat(source_path, &st) < 0) return theme;
+
+    if (theme && is_fresh(theme, source_path, cache_path, &st)) return theme;
+
+    /* Compile first: a source that no longer compiles keeps the previous cache */
+    if (!theme_compile(source_path, cache_path, depth)) return theme;
+
+    t_theme *fresh = map_cache(cache_path, depth);
+    if (!fresh) return theme;
+
+    theme_close(theme);
+    return fresh;
+}
+
+
+const char *theme_get(const t_theme *theme, const char *name, size_t *len) {
+    if (!theme || !name) return NULL;
+
+    size_t name_len = strlen(name);
+    uint32_t hash = theme_hash32(name, name_len, 0x811C9DC5u);
+    const t_theme_entry *entries = theme->entries;
+    size_t lo = 0, hi = theme->header->nb_entries;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entries[mid].name_hash < hash) lo = mid + 1;
+        else hi = mid;
+    }
+
+    for (; lo < theme->header->nb_entries && entries[lo].name_hash == hash; lo++) {
+        uint16_t n;
+        const unsigned char *s = pool_string(theme, entries[lo].name_offset, &n);
+        if (n != name_len || memcmp(s, name, n) != 0) continue;
+
+        s = pool_string(theme, entries[lo].seq_offset, &n);
+        if (len) *len = n;
+        return (const char *)s;
+    }
+    return NULL;
+}
+
+
+void theme_close(t_theme *theme) {
+    if (!theme) return;
+
+    munmap((void *)theme->map, theme->size);
+    free(theme);
+}
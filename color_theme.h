@@ -0,0 +1,107 @@
+/**
+ * @file color_theme.h
+ * @brief Text themes compiled to a binary cache that later runs mmap and use in place.
+ *
+ * A theme file holds one named style per line:
+ *
+ *     ; comment
+ *     error   = bold #ff5555
+ *     warning = yellow on #303030
+ *     link    = underline rgb(80, 160, 255)
+ *
+ * Words are Style names (bold, dim, italic, underline, double_underline, blink, reverse,
+ * hidden, strikethrough), foreground colors and "on <color>" backgrounds, colors in any
+ * form color_parse() accepts (names use '-' or '_' instead of spaces).
+ *
+ * The cache is a versioned blob of pre-rendered, length-prefixed, NUL-terminated escape
+ * sequences indexed by name. theme_load() maps it read-only, validates it and returns
+ * pointers into the mapping: no parsing, no allocation per style. The cache is rebuilt
+ * only when the source mtime and content hash both changed, or when the escape prefix
+ * or color depth differs.
+ */
+
+#ifndef COLOR_THEME_H
+#define COLOR_THEME_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define THEME_MAGIC "CLTHEME"
+#define THEME_VERSION 1
+#define THEME_NAME_MAX 64
+
+/**
+ * @brief On-disk header, followed by the entry index then the string pool.
+ */
+typedef struct s_theme_header {
+    char magic[8];            /**< THEME_MAGIC, NUL-padded */
+    uint32_t version;         /**< THEME_VERSION */
+    uint32_t nb_entries;
+    uint64_t source_mtime_ns; /**< Source modification time when compiled */
+    uint64_t source_size;
+    uint64_t source_hash;     /**< FNV-1a 64 of the source content */
+    uint32_t render_hash;     /**< Escape prefix and color depth the sequences were rendered with */
+    uint32_t pool_offset;     /**< String pool start, from the beginning of the file */
+    uint32_t total_size;
+    uint32_t checksum;        /**< FNV-1a 32 of everything after the header */
+} t_theme_header;
+
+/**
+ * @brief Index entry, sorted by name_hash.
+ * * Strings in the pool are stored as a uint16_t length, the bytes and a NUL.
+ */
+typedef struct s_theme_entry {
+    uint32_t name_hash;
+    uint32_t name_offset;     /**< Offset of the name's length prefix in the pool */
+    uint32_t seq_offset;      /**< Offset of the sequence's length prefix in the pool */
+} t_theme_entry;
+
+/**
+ * @brief Loaded (mapped) theme.
+ */
+typedef struct s_theme {
+    const unsigned char *map;
+    size_t size;
+    const t_theme_header *header;
+    const t_theme_entry *entries;
+    const unsigned char *pool;
+} t_theme;
+
+/**
+ * @brief Compiles a text theme into a binary cache (written atomically through a temp file).
+ * @param depth GRADIENT_DEPTH_24 for TrueColor sequences, GRADIENT_DEPTH_8 for the 256-color palette.
+ * @return 1 on success, 0 on I/O or syntax error.
+ */
+int theme_compile(const char *source_path, const char *cache_path, GradientDepth depth);
+
+/**
+ * @brief Maps the cache, rebuilding it first when it is missing, invalid or stale.
+ * * If the source no longer compiles, the previous cache is returned when it is valid
+ * for this escape prefix and depth.
+ * @return The theme (release with theme_close()), or NULL on error.
+ */
+t_theme *theme_load(const char *source_path, const char *cache_path, GradientDepth depth);
+
+/**
+ * @brief Gets a style sequence, pointing into the mapped cache.
+ * @param len Receives the sequence length, may be NULL.
+ * @return The NUL-terminated sequence, or NULL if the name is unknown.
+ */
+const char *theme_get(const t_theme *theme, const char *name, size_t *len);
+
+/**
+ * @brief Unmaps the cache and frees the theme.
+ */
+void theme_close(t_theme *theme);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_THEME_H */
@@ -0,0 +1,572 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "color_lib.h"
+#include "color_width.h"
+#include "color_vt.h"
+
+
+static const t_vt_pen DEFAULT_PEN = {{VT_COLOR_DEFAULT, 0}, {VT_COLOR_DEFAULT, 0}, {VT_COLOR_DEFAULT, 0}, 0};
+
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+static t_vt_cell *cell_at(t_vt *vt, uint16_t row, uint16_t col) {
+    return &vt->cells[(size_t)row * vt->cols + col];
+}
+
+
+static void clear_cells(t_vt *vt, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        vt->cells[i].ch = ' ';
+        vt->cells[i].pen = vt->pen;
+        /* Erased cells keep the background only */
+        vt->cells[i].pen.fg = DEFAULT_PEN.fg;
+        vt->cells[i].pen.ul = DEFAULT_PEN.ul;
+        vt->cells[i].pen.attrs = 0;
+    }
+}
+
+
+t_vt *vt_new(uint16_t rows, uint16_t cols) {
+    if (rows == 0 || cols == 0) return NULL;
+
+    t_vt *vt = malloc(sizeof(t_vt));
+    if (!vt) return NULL;
+
+    vt->cells = malloc((size_t)rows * cols * sizeof(t_vt_cell));
+    if (!vt->cells) {free(vt);return NULL;}
+
+    vt->rows = rows;
+    vt->cols = cols;
+    vt_reset(vt);
+
+    return vt;
+}
+
+
+void vt_free(t_vt *vt) {
+    if (!vt) return;
+    free(vt->cells);
+    free(vt);
+}
+
+
+void vt_reset(t_vt *vt) {
+    if (!vt) return;
+
+    vt->row = 0;
+    vt->col = 0;
+    vt->wrap_pending = 0;
+    vt->cursor_visible = 1;
+    vt->onlcr = 1;
+    vt->saved_row = 0;
+    vt->saved_col = 0;
+    vt->pen = DEFAULT_PEN;
+
+    vt->state = VT_STATE_GROUND;
+    vt_csi_reset(&vt->csi);
+    vt->utf8_cp = 0;
+    vt->utf8_left = 0;
+    vt->reply_len = 0;
+
+    memset(&vt->frame, 0, sizeof(t_vt_stats));
+    memset(&vt->total, 0, sizeof(t_vt_stats));
+
+    clear_cells(vt, 0, (size_t)vt->rows * vt->cols);
+}
+
+
+/* --- Grid operations --- */
+
+static void scroll_up(t_vt *vt) {
+    size_t row_size = vt->cols;
+
+    memmove(vt->cells, vt->cells + row_size, (size_t)(vt->rows - 1) * row_size * sizeof(t_vt_cell));
+    clear_cells(vt, (size_t)(vt->rows - 1) * row_size, row_size);
+}
+
+
+static void line_feed(t_vt *vt) {
+    vt->wrap_pending = 0;
+    if (vt->row + 1 >= vt->rows) scroll_up(vt);
+    else vt->row++;
+}
+
+
+/* Blanks the other half of any wide glyph that cells [col, col + width) of the row cut through */
+static void break_wide(t_vt *vt, uint16_t col, int width) {
+    t_vt_cell *row = cell_at(vt, vt->row, 0);
+    size_t after = (size_t)col + width;
+
+    if (row[col].ch == 0 && col > 0) row[col - 1].ch = ' ';
+    if (after < vt->cols && row[after].ch == 0) row[after].ch = ' ';
+}
+
+
+static void put_glyph(t_vt *vt, uint32_t cp) {
+    int width = codepoint_width(cp);
+
+    if (width == 0) return;
+    if (width > vt->cols) {
+        /* A wide glyph cannot fit a 1-column screen */
+        cp = 0xFFFD;
+        width = 1;
+    }
+    if (vt->wrap_pending || vt->col + width > vt->cols) {
+        vt->col = 0;
+        line_feed(vt);
+    }
+
+    break_wide(vt, vt->col, width);
+
+    t_vt_cell *cell = cell_at(vt, vt->row, vt->col);
+    cell->ch = cp;
+    cell->pen = vt->pen;
+    if (width == 2) {
+        cell[1].ch = 0;
+        cell[1].pen = vt->pen;
+    }
+    vt->frame.cells++;
+
+    if (vt->col + width >= vt->cols) {
+        vt->col = vt->cols - 1;
+        vt->wrap_pending = 1;
+    } else {
+        vt->col += width;
+    }
+}
+
+
+static void move_to(t_vt *vt, int row, int col) {
+    if (row < 0) row = 0;
+    if (row >= vt->rows) row = vt->rows - 1;
+    if (col < 0) col = 0;
+    if (col >= vt->cols) col = vt->cols - 1;
+
+    vt->row = (uint16_t)row;
+    vt->col = (uint16_t)col;
+    vt->wrap_pending = 0;
+}
+
+
+static void push_reply(t_vt *vt, const char *msg, size_t len) {
+    if (vt->reply_len + len > VT_REPLY_SIZE) return;
+    memcpy(vt->reply + vt->reply_len, msg, len);
+    vt->reply_len += len;
+}
+
+
+/* --- SGR --- */
+
+static int sgr_param(const int *params, int nb_params, int i, int def) {
+    if (i >= nb_params || params[i] < 0) return def;
+    return params[i];
+}
+
+
+static int param(const t_vt *vt, int i, int def) {
+    return sgr_param(vt->csi.params, vt->csi.nb_params, i, def);
+}
+
+
+/* Parses "5;n" or "2;r;g;b" after a 38/48/58 parameter; returns the number of parameters used */
+static int parse_extended_color(const int *params, int nb_params, int i, t_vt_color *color) {
+    int mode = sgr_param(params, nb_params, i, -1);
+
+    if (mode == 5 && i + 1 < nb_params) {
+        color->kind = VT_COLOR_INDEX;
+        color->value = (uint32_t)(sgr_param(params, nb_params, i + 1, 0) & 0xFF);
+        return 2;
+    }
+    if (mode == 2 && i + 3 < nb_params) {
+        color->kind = VT_COLOR_RGB;
+        color->value = ((uint32_t)(sgr_param(params, nb_params, i + 1, 0) & 0xFF) << 16)
+                     | ((uint32_t)(sgr_param(params, nb_params, i + 2, 0) & 0xFF) << 8)
+                     | (uint32_t)(sgr_param(params, nb_params, i + 3, 0) & 0xFF);
+        return 4;
+    }
+    return nb_params - i;
+}
+
+
+void vt_pen_apply_sgr(t_vt_pen *pen, const int *params, int nb_params) {
+    if (nb_params == 0) {
+        *pen = DEFAULT_PEN;
+        return;
+    }
+
+    for (int i = 0; i < nb_params; i++) {
+        int p = sgr_param(params, nb_params, i, 0);
+
+        if (p == 0) *pen = DEFAULT_PEN;
+        else if (p == 1) pen->attrs |= VT_ATTR_BOLD;
+        else if (p == 2) pen->attrs |= VT_ATTR_DIM;
+        else if (p == 3) pen->attrs |= VT_ATTR_ITALIC;
+        else if (p == 4) pen->attrs |= VT_ATTR_UNDERLINE;
+        else if (p == 5 || p == 6) pen->attrs |= VT_ATTR_BLINK;
+        else if (p == 7) pen->attrs |= VT_ATTR_REVERSE;
+        else if (p == 8) pen->attrs |= VT_ATTR_HIDDEN;
+        else if (p == 9) pen->attrs |= VT_ATTR_STRIKETHROUGH;
+        else if (p == 21) pen->attrs |= VT_ATTR_DOUBLE_UNDERLINE;
+        else if (p == 22) pen->attrs &= ~(VT_ATTR_BOLD | VT_ATTR_DIM);
+        else if (p == 23) pen->attrs &= ~VT_ATTR_ITALIC;
+        else if (p == 24) pen->attrs &= ~(VT_ATTR_UNDERLINE | VT_ATTR_DOUBLE_UNDERLINE);
+        else if (p == 25) pen->attrs &= ~VT_ATTR_BLINK;
+        else if (p == 27) pen->attrs &= ~VT_ATTR_REVERSE;
+        else if (p == 28) pen->attrs &= ~VT_ATTR_HIDDEN;
+        else if (p == 29) pen->attrs &= ~VT_ATTR_STRIKETHROUGH;
+        else if (p >= 30 && p <= 37) { pen->fg.kind = VT_COLOR_INDEX; pen->fg.value = p - 30; }
+        else if (p == 38) i += parse_extended_color(params, nb_params, i + 1, &pen->fg);
+        else if (p == 39) pen->fg = DEFAULT_PEN.fg;
+        else if (p >= 40 && p <= 47) { pen->bg.kind = VT_COLOR_INDEX; pen->bg.value = p - 40; }
+        else if (p == 48) i += parse_extended_color(params, nb_params, i + 1, &pen->bg);
+        else if (p == 49) pen->bg = DEFAULT_PEN.bg;
+        else if (p == 51) pen->attrs |= VT_ATTR_FRAMED;
+        else if (p == 52) pen->attrs |= VT_ATTR_ENCIRCLED;
+        else if (p == 53) pen->attrs |= VT_ATTR_OVERLINE;
+        else if (p == 54) pen->attrs &= ~(VT_ATTR_FRAMED | VT_ATTR_ENCIRCLED);
+        else if (p == 55) pen->attrs &= ~VT_ATTR_OVERLINE;
+        else if (p == 58) i += parse_extended_color(params, nb_params, i + 1, &pen->ul);
+        else if (p == 59) pen->ul = DEFAULT_PEN.ul;
+        else if (p >= 90 && p <= 97) { pen->fg.kind = VT_COLOR_INDEX; pen->fg.value = p - 90 + 8; }
+        else if (p >= 100 && p <= 107) { pen->bg.kind = VT_COLOR_INDEX; pen->bg.value = p - 100 + 8; }
+        /* Fonts, ideograms, super/subscript: accepted, not rendered */
+    }
+}
+
+
+static void apply_sgr(t_vt *vt) {
+    vt_pen_apply_sgr(&vt->pen, vt->csi.params, vt->csi.nb_params);
+}
+
+
+/* --- CSI dispatch --- */
+
+static void erase_display(t_vt *vt, int mode) {
+    size_t cursor = (size_t)vt->row * vt->cols + vt->col;
+    size_t total = (size_t)vt->rows * vt->cols;
+
+    if (mode == 0) clear_cells(vt, cursor, total - cursor);
+    else if (mode == 1) clear_cells(vt, 0, cursor + 1);
+    else if (mode == 2) clear_cells(vt, 0, total);
+    /* 3 clears the scrollback, which the emulator does not keep */
+}
+
+
+static void erase_line(t_vt *vt, int mode) {
+    size_t line = (size_t)vt->row * vt->cols;
+
+    if (mode == 0) clear_cells(vt, line + vt->col, vt->cols - vt->col);
+    else if (mode == 1) clear_cells(vt, line, vt->col + 1);
+    else if (mode == 2) clear_cells(vt, line, vt->cols);
+}
+
+
+static void dispatch_csi(t_vt *vt, char final) {
+    t_vt_stats *st = &vt->frame;
+    int n = param(vt, 0, 1);
+
+    if (n == 0) n = 1;
+
+    if (vt->csi.private_marker == '?') {
+        if ((final == 'h' || final == 'l') && param(vt, 0, 0) == 25) {
+            vt->cursor_visible = (final == 'h');
+            st->cursor++;
+        } else {
+            st->unknown++;
+        }
+        return;
+    }
+
+    switch (final) {
+        case 'm': apply_sgr(vt); st->sgr++; break;
+        case 'H':
+        case 'f': move_to(vt, param(vt, 0, 1) - 1, param(vt, 1, 1) - 1); st->cursor++; break;
+        case 'A': move_to(vt, vt->row - n, vt->col); st->cursor++; break;
+        case 'B': move_to(vt, vt->row + n, vt->col); st->cursor++; break;
+        case 'C': move_to(vt, vt->row, vt->col + n); st->cursor++; break;
+        case 'D': move_to(vt, vt->row, vt->col - n); st->cursor++; break;
+        case 'G': move_to(vt, vt->row, param(vt, 0, 1) - 1); st->cursor++; break;
+        case 'd': move_to(vt, param(vt, 0, 1) - 1, vt->col); st->cursor++; break;
+        case 's': vt->saved_row = vt->row; vt->saved_col = vt->col; st->cursor++; break;
+        case 'u': move_to(vt, vt->saved_row, vt->saved_col); st->cursor++; break;
+        case 'J': erase_display(vt, param(vt, 0, 0)); st->erase++; break;
+        case 'K': erase_line(vt, param(vt, 0, 0)); st->erase++; break;
+        case 'n':
+            if (param(vt, 0, 0) == 6) {
+                char msg[32];
+                int len = snprintf(msg, sizeof(msg), "\033[%d;%dR", vt->row + 1, vt->col + 1);
+                push_reply(vt, msg, (size_t)len);
+            }
+            st->cursor++;
+            break;
+        default: st->unknown++; break;
+    }
+}
+
+
+/* --- Byte parser --- */
+
+static void ground_byte(t_vt *vt, unsigned char c) {
+    if (vt->utf8_left > 0) {
+        if ((c & 0xC0) == 0x80) {
+            vt->frame.text_bytes++;
+            vt->utf8_cp = (vt->utf8_cp << 6) | (c & 0x3F);
+            if (--vt->utf8_left == 0) put_glyph(vt, vt->utf8_cp);
+            return;
+        }
+        /* Truncated sequence: show a replacement glyph, then handle c normally */
+        vt->utf8_left = 0;
+        put_glyph(vt, 0xFFFD);
+    }
+
+    if (c >= 0x20 && c < 0x7F) {
+        vt->frame.text_bytes++;
+        put_glyph(vt, c);
+        return;
+    }
+    if (c >= 0x80) {
+        vt->frame.text_bytes++;
+        if (c >= 0xC2 && c < 0xE0) { vt->utf8_cp = c & 0x1F; vt->utf8_left = 1; }
+        else if (c >= 0xE0 && c < 0xF0) { vt->utf8_cp = c & 0x0F; vt->utf8_left = 2; }
+        else if (c >= 0xF0 && c < 0xF5) { vt->utf8_cp = c & 0x07; vt->utf8_left = 3; }
+        else put_glyph(vt, 0xFFFD);
+        return;
+    }
+
+    switch (c) {
+        case 0x1B:
+            vt->state = VT_STATE_ESC;
+            return;
+        case '\r':
+            vt->col = 0;
+            vt->wrap_pending = 0;
+            break;
+        case '\n':
+        case '\v':
+        case '\f':
+            if (vt->onlcr) vt->col = 0;
+            line_feed(vt);
+            break;
+        case '\b':
+            if (vt->col > 0) vt->col--;
+            vt->wrap_pending = 0;
+            break;
+        case '\t':
+            move_to(vt, vt->row, (vt->col / 8 + 1) * 8);
+            break;
+        case 0x07:
+            break;
+        default:
+            return;
+    }
+    vt->frame.controls++;
+}
+
+
+static void esc_byte(t_vt *vt, unsigned char c) {
+    vt->state = VT_STATE_GROUND;
+    vt->frame.sequences++;
+
+    if (c == '[') {
+        vt->state = VT_STATE_CSI;
+        vt_csi_reset(&vt->csi);
+        return;
+    }
+    if (c == ']' || c == 'P' || c == '_' || c == '^') {
+        vt->state = VT_STATE_STRING;
+        vt->frame.unknown++;
+        return;
+    }
+    if (c == '7') { vt->saved_row = vt->row; vt->saved_col = vt->col; vt->frame.cursor++; return; }
+    if (c == '8') { move_to(vt, vt->saved_row, vt->saved_col); vt->frame.cursor++; return; }
+    if (c == 'c') {
+        t_vt_stats frame = vt->frame;
+        t_vt_stats total = vt->total;
+        vt_reset(vt);
+        vt->frame = frame;
+        vt->total = total;
+        return;
+    }
+    vt->frame.unknown++;
+}
+
+
+void vt_csi_reset(t_vt_csi *csi) {
+    csi->private_marker = 0;
+    csi->nb_params = 0;
+}
+
+
+int vt_csi_byte(t_vt_csi *csi, unsigned char c) {
+    if (c >= '0' && c <= '9') {
+        if (csi->nb_params == 0) csi->params[csi->nb_params++] = -1;
+        int *p = &csi->params[csi->nb_params - 1];
+        if (*p < 0) *p = 0;
+        if (*p < 65535) *p = *p * 10 + (c - '0');
+        return 0;
+    }
+    if (c == ';' || c == ':') {
+        if (csi->nb_params == 0) csi->params[csi->nb_params++] = -1;
+        if (csi->nb_params < VT_MAX_PARAMS) csi->params[csi->nb_params++] = -1;
+        return 0;
+    }
+    if (c >= 0x3C && c <= 0x3F) {
+        csi->private_marker = (char)c;
+        return 0;
+    }
+    if ((c >= 0x40 && c <= 0x7E) || c == 0x1B) return c;
+
+    /* Intermediate bytes are ignored */
+    return 0;
+}
+
+
+static void csi_byte(t_vt *vt, unsigned char c) {
+    int final = vt_csi_byte(&vt->csi, c);
+
+    if (final == 0x1B) {
+        vt->frame.unknown++;
+        vt->state = VT_STATE_ESC;
+    } else if (final) {
+        vt->state = VT_STATE_GROUND;
+        dispatch_csi(vt, (char)final);
+    }
+}
+
+
+void vt_write(t_vt *vt, const char *data, size_t len) {
+    if (!vt || !data) return;
+
+    uint64_t start = now_ns();
+    const unsigned char *p = (const unsigned char *)data;
+
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = p[i];
+
+        switch (vt->state) {
+            case VT_STATE_GROUND: ground_byte(vt, c); break;
+            case VT_STATE_ESC: esc_byte(vt, c); break;
+            case VT_STATE_CSI: csi_byte(vt, c); break;
+            case VT_STATE_STRING:
+                if (c == 0x07) vt->state = VT_STATE_GROUND;
+                else if (c == 0x1B) vt->state = VT_STATE_STRING_ESC;
+                break;
+            case VT_STATE_STRING_ESC:
+                vt->state = (c == '\\') ? VT_STATE_GROUND : VT_STATE_STRING;
+                break;
+        }
+    }
+
+    vt->frame.bytes += len;
+    vt->frame.parse_ns += now_ns() - start;
+}
+
+
+static void add_stats(t_vt_stats *dst, const t_vt_stats *src) {
+    dst->bytes += src->bytes;
+    dst->text_bytes += src->text_bytes;
+    dst->controls += src->controls;
+    dst->sequences += src->sequences;
+    dst->sgr += src->sgr;
+    dst->cursor += src->cursor;
+    dst->erase += src->erase;
+    dst->unknown += src->unknown;
+    dst->cells += src->cells;
+    dst->parse_ns += src->parse_ns;
+}
+
+
+t_vt_stats vt_frame_end(t_vt *vt) {
+    t_vt_stats frame;
+
+    memset(&frame, 0, sizeof(frame));
+    if (!vt) return frame;
+
+    frame = vt->frame;
+    add_stats(&vt->total, &frame);
+    memset(&vt->frame, 0, sizeof(t_vt_stats));
+
+    return frame;
+}
+
+
+const t_vt_cell *vt_cell(const t_vt *vt, uint16_t row, uint16_t col) {
+    if (!vt || row < 1 || col < 1 || row > vt->rows || col > vt->cols) return NULL;
+
+    return &vt->cells[(size_t)(row - 1) * vt->cols + (col - 1)];
+}
+
+
+t_cursor_pos vt_cursor(const t_vt *vt) {
+    t_cursor_pos pos = {0, 0};
+
+    if (!vt) return pos;
+    pos.row = vt->row + 1;
+    pos.col = vt->col + 1;
+    return pos;
+}
+
+
+static size_t put_utf8(char *dst, uint32_t cp) {
+    if (cp < 0x80) { dst[0] = (char)cp; return 1; }
+    if (cp < 0x800) {
+        dst[0] = (char)(0xC0 | (cp >> 6));
+        dst[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        dst[0] = (char)(0xE0 | (cp >> 12));
+        dst[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        dst[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    dst[0] = (char)(0xF0 | (cp >> 18));
+    dst[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    dst[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    dst[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+
+size_t vt_row_text(const t_vt *vt, uint16_t row, char *dst, size_t size) {
+    if (!vt || !dst || size == 0 || row < 1 || row > vt->rows) return 0;
+
+    const t_vt_cell *line = &vt->cells[(size_t)(row - 1) * vt->cols];
+    size_t last = vt->cols;
+    size_t len = 0;
+
+    while (last > 0 && line[last - 1].ch == ' ') last--;
+
+    for (size_t i = 0; i < last; i++) {
+        if (line[i].ch == 0) continue;
+        if (len + 4 >= size) return 0;
+        len += put_utf8(dst + len, line[i].ch);
+    }
+    dst[len] = '\0';
+
+    return len;
+}
+
+
+size_t vt_read_reply(t_vt *vt, char *dst, size_t size) {
+    if (!vt || !dst) return 0;
+
+    size_t n = (vt->reply_len < size) ? vt->reply_len : size;
+    memcpy(dst, vt->reply, n);
+    memmove(vt->reply, vt->reply + n, vt->reply_len - n);
+    vt->reply_len -= n;
+
+    return n;
+}
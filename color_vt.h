@@ -0,0 +1,204 @@
+/**
+ * @file color_vt.h
+ * @brief Headless virtual terminal: parses the byte stream the library emits into a cell grid.
+ *
+ * Understands UTF-8 text, CR/LF/BS/TAB, SGR (4-bit, 8-bit, 24-bit and underline colors,
+ * every Style attribute), cursor moves (CUP, CUU/CUD/CUF/CUB, CHA, VPA, SCP/RCP, DECTCEM),
+ * erasing (ED, EL) and replies to DSR. Used to check that a frame produces the expected
+ * screen and to measure bytes, sequences and parse time per frame without a real terminal.
+ */
+
+#ifndef COLOR_VT_H
+#define COLOR_VT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "color_lib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief How a cell color is expressed.
+ */
+typedef enum {
+    VT_COLOR_DEFAULT = 0, ///< Terminal default (SGR 39/49/59)
+    VT_COLOR_INDEX   = 1, ///< Palette index: 0..15 for Fore/Back, 0..255 for 8-bit colors
+    VT_COLOR_RGB     = 2  ///< TrueColor, value is 0xRRGGBB
+} VtColorKind;
+
+typedef struct s_vt_color {
+    uint8_t kind;   /**< VtColorKind */
+    uint32_t value; /**< Palette index or 0xRRGGBB */
+} t_vt_color;
+
+/**
+ * @brief Cell attributes set through SGR.
+ */
+typedef enum {
+    VT_ATTR_BOLD             = (1 << 0),
+    VT_ATTR_DIM              = (1 << 1),
+    VT_ATTR_ITALIC           = (1 << 2),
+    VT_ATTR_UNDERLINE        = (1 << 3),
+    VT_ATTR_BLINK            = (1 << 4),
+    VT_ATTR_REVERSE          = (1 << 5),
+    VT_ATTR_HIDDEN           = (1 << 6),
+    VT_ATTR_STRIKETHROUGH    = (1 << 7),
+    VT_ATTR_DOUBLE_UNDERLINE = (1 << 8),
+    VT_ATTR_OVERLINE         = (1 << 9),
+    VT_ATTR_FRAMED           = (1 << 10),
+    VT_ATTR_ENCIRCLED        = (1 << 11)
+} VtAttr;
+
+/**
+ * @brief Pen state applied to printed cells.
+ */
+typedef struct s_vt_pen {
+    t_vt_color fg;
+    t_vt_color bg;
+    t_vt_color ul;    /**< Underline color (SGR 58) */
+    uint16_t attrs;   /**< VtAttr bits */
+} t_vt_pen;
+
+typedef struct s_vt_cell {
+    uint32_t ch;      /**< Codepoint, ' ' when blank, 0 for the right half of a wide glyph */
+    t_vt_pen pen;
+} t_vt_cell;
+
+/**
+ * @brief Output accounting, per frame or cumulative.
+ */
+typedef struct s_vt_stats {
+    size_t bytes;        /**< Every byte received */
+    size_t text_bytes;   /**< Bytes of printed glyphs */
+    size_t controls;     /**< CR, LF, BS, TAB, BEL */
+    size_t sequences;    /**< Escape sequences of any kind */
+    size_t sgr;          /**< SGR sequences */
+    size_t cursor;       /**< Cursor motion / visibility sequences */
+    size_t erase;        /**< ED / EL sequences */
+    size_t unknown;      /**< Sequences the emulator ignored */
+    size_t cells;        /**< Glyphs written to the grid */
+    uint64_t parse_ns;   /**< Time spent in vt_write() */
+} t_vt_stats;
+
+typedef enum {
+    VT_STATE_GROUND,
+    VT_STATE_ESC,
+    VT_STATE_CSI,
+    VT_STATE_STRING,
+    VT_STATE_STRING_ESC
+} VtState;
+
+#define VT_MAX_PARAMS 16
+#define VT_REPLY_SIZE 64
+
+/**
+ * @brief CSI tokenizer state: what follows "ESC [" up to the final byte.
+ */
+typedef struct s_vt_csi {
+    char private_marker;       /**< '<' '=' '>' or '?', 0 if none */
+    int params[VT_MAX_PARAMS]; /**< Negative for an omitted parameter */
+    int nb_params;
+} t_vt_csi;
+
+typedef struct s_vt {
+    uint16_t rows;
+    uint16_t cols;
+    t_vt_cell *cells;          /**< rows * cols cells, row-major */
+
+    uint16_t row;              /**< Cursor, 0-based */
+    uint16_t col;
+    unsigned char wrap_pending;
+    unsigned char cursor_visible;
+    unsigned char onlcr;       /**< LF also returns the carriage, as a cooked tty does (default 1) */
+    uint16_t saved_row;
+    uint16_t saved_col;
+    t_vt_pen pen;
+
+    /* Parser */
+    VtState state;
+    t_vt_csi csi;
+    uint32_t utf8_cp;
+    int utf8_left;
+
+    char reply[VT_REPLY_SIZE]; /**< Pending answers to DSR queries */
+    size_t reply_len;
+
+    t_vt_stats frame;
+    t_vt_stats total;
+} t_vt;
+
+/**
+ * @brief Creates a blank terminal.
+ * @return The terminal (free it with vt_free()), or NULL on invalid size or allocation failure.
+ */
+t_vt *vt_new(uint16_t rows, uint16_t cols);
+
+void vt_free(t_vt *vt);
+
+/**
+ * @brief Clears the grid, homes the cursor, resets the pen, the parser and the statistics.
+ */
+void vt_reset(t_vt *vt);
+
+/**
+ * @brief Feeds bytes to the terminal; sequences may be split across calls.
+ */
+void vt_write(t_vt *vt, const char *data, size_t len);
+
+/**
+ * @brief Ends a frame: returns the statistics since the previous call and starts a new frame.
+ */
+t_vt_stats vt_frame_end(t_vt *vt);
+
+/**
+ * @brief Cell at a 1-based position, or NULL when out of the grid.
+ */
+const t_vt_cell *vt_cell(const t_vt *vt, uint16_t row, uint16_t col);
+
+/**
+ * @brief 1-based cursor position.
+ */
+t_cursor_pos vt_cursor(const t_vt *vt);
+
+/**
+ * @brief Writes the text of a 1-based row as UTF-8, trailing blanks removed.
+ * @return Number of bytes written (NUL excluded), or 0 if the row is invalid or dst too small.
+ */
+size_t vt_row_text(const t_vt *vt, uint16_t row, char *dst, size_t size);
+
+/**
+ * @brief Pops the replies the terminal would have sent back (e.g. "\033[12;40R" for Cursor.DSR).
+ * @return Number of bytes copied.
+ */
+size_t vt_read_reply(t_vt *vt, char *dst, size_t size);
+
+/**
+ * @brief Starts a CSI sequence (after "ESC [").
+ */
+void vt_csi_reset(t_vt_csi *csi);
+
+/**
+ * @brief Feeds one byte of a CSI sequence, as the emulator parses it.
+ * * Shared with the converters that follow the stream without a grid (e.g. color_html.h).
+ * Intermediate bytes and control characters other than ESC are skipped.
+ * @return The final byte (0x40-0x7E) once the sequence is complete, 0x1B if an ESC
+ *         cancelled it, 0 while it goes on.
+ */
+int vt_csi_byte(t_vt_csi *csi, unsigned char c);
+
+/**
+ * @brief Applies SGR parameters to a pen, as the emulator does for "ESC [ ... m".
+ * * Shared with the converters that track a pen without a grid (e.g. color_html.h).
+ * @param params Parameters, negative for an omitted one ("ESC [ ; 1 m").
+ * @param nb_params Number of parameters, 0 resets the pen.
+ */
+void vt_pen_apply_sgr(t_vt_pen *pen, const int *params, int nb_params);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_VT_H */
@@ -0,0 +1,299 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* COLOR_WIDTH_NO_SSE2 forces the portable path (used to test it on x86) */
+#if defined(__SSE2__) && !defined(COLOR_WIDTH_NO_SSE2)
+#define COLOR_WIDTH_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "color_lib.h"
+#include "color_width.h"
+
+
+typedef struct s_range {
+    uint32_t first;
+    uint32_t last;
+} t_range;
+
+
+/* Combining marks, joiners and other codepoints drawn on top of the previous cell */
+static const t_range ZERO_WIDTH[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF},
+    {0x05C1, 0x05C2}, {0x05C4, 0x05C5}, {0x05C7, 0x05C7}, {0x0610, 0x061A},
+    {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC}, {0x06DF, 0x06E4},
+    {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A},
+    {0x0900, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C}, {0x0941, 0x0948},
+    {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A},
+    {0x0E47, 0x0E4E}, {0x1160, 0x11FF}, {0x1AB0, 0x1AFF}, {0x1DC0, 0x1DFF},
+    {0x200B, 0x200F}, {0x202A, 0x202E}, {0x2060, 0x2064}, {0x20D0, 0x20FF},
+    {0x302A, 0x302D}, {0x3099, 0x309A}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F},
+    {0xFEFF, 0xFEFF}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE007F}, {0xE0100, 0xE01EF}
+};
+
+
+/* East-Asian Wide and Fullwidth blocks, emoji presentation */
+static const t_range DOUBLE_WIDTH[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC},
+    {0x23F0, 0x23F0}, {0x23F3, 0x23F3}, {0x25FD, 0x25FE}, {0x2614, 0x2615},
+    {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE},
+    {0x26D4, 0x26D4}, {0x26EA, 0x26EA}, {0x26F2, 0x26F3}, {0x26F5, 0x26F5},
+    {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755},
+    {0x2757, 0x2757}, {0x2795, 0x2797}, {0x27B0, 0x27B0}, {0x27BF, 0x27BF},
+    {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x4DBF}, {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xA960, 0xA97F},
+    {0xAC00, 0xD7A3}, {0xF900, 0xFAFF}, {0xFE10, 0xFE19}, {0xFE30, 0xFE6F},
+    {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF},
+    {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E},
+    {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F64F}, {0x1F680, 0x1F6FF},
+    {0x1F7E0, 0x1F7EB}, {0x1F900, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+    {0x30000, 0x3FFFD}
+};
+
+
+static int in_table(uint32_t cp, const t_range *table, size_t count) {
+    size_t lo = 0;
+    size_t hi = count;
+
+    if (cp < table[0].first || cp > table[count - 1].last) return 0;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp > table[mid].last) lo = mid + 1;
+        else if (cp < table[mid].first) hi = mid;
+        else return 1;
+    }
+    return 0;
+}
+
+
+int codepoint_width(uint32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (cp < 0x300) return 1;
+    if (in_table(cp, ZERO_WIDTH, sizeof(ZERO_WIDTH) / sizeof(ZERO_WIDTH[0]))) return 0;
+    if (in_table(cp, DOUBLE_WIDTH, sizeof(DOUBLE_WIDTH) / sizeof(DOUBLE_WIDTH[0]))) return 2;
+    return 1;
+}
+
+
+/* Length of the leading run of printable ASCII (0x20..0x7E) */
+static size_t ascii_run(const unsigned char *p, size_t len) {
+    size_t i = 0;
+
+#if defined(COLOR_WIDTH_SSE2)
+    const __m128i lo = _mm_set1_epi8(0x1F);
+    const __m128i hi = _mm_set1_epi8(0x7F);
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        /* Signed compares: bytes >= 0x80 are negative and fail the lower bound */
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(ok);
+        if (mask != 0xFFFF) return i + __builtin_ctz(~mask);
+    }
+#else
+    const uint64_t ones = ~0ULL / 255;
+    const uint64_t high = ones * 0x80;
+
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x;
+        memcpy(&x, p + i, 8);
+        uint64_t below = (x - ones * 0x20) & ~x;
+        uint64_t above = (x + ones * (0x7F - 0x7E)) | x;
+        if ((below | above) & high) break;
+    }
+#endif
+    while (i < len && p[i] >= 0x20 && p[i] < 0x7F) i++;
+    return i;
+}
+
+
+/* Length of the escape sequence starting at p (p[0] == ESC) */
+static size_t escape_len(const unsigned char *p, size_t len) {
+    size_t i = 2;
+
+    if (len < 2) return len;
+
+    if (p[1] == '[') {
+        while (i < len && !(p[i] >= 0x40 && p[i] <= 0x7E)) i++;
+        return (i < len) ? i + 1 : len;
+    }
+    if (p[1] == ']' || p[1] == 'P' || p[1] == '_' || p[1] == '^') {
+        /* String sequences end with BEL or ST (ESC \) */
+        while (i < len) {
+            if (p[i] == 0x07) return i + 1;
+            if (p[i] == 0x1B && i + 1 < len && p[i + 1] == '\\') return i + 2;
+            i++;
+        }
+        return len;
+    }
+    return 2;
+}
+
+
+/* Length of the UTF-8 glyph starting at p; invalid bytes count as one column each */
+static size_t glyph_len(const unsigned char *p, size_t len, int *width) {
+    unsigned char c = p[0];
+    size_t n;
+    uint32_t cp;
+
+    if (c < 0x80) {
+        *width = (c >= 0x20 && c != 0x7F);
+        return 1;
+    }
+
+    if (c >= 0xF0 && c <= 0xF4) { n = 4; cp = c & 0x07; }
+    else if (c >= 0xE0 && c < 0xF0) { n = 3; cp = c & 0x0F; }
+    else if (c >= 0xC2 && c < 0xE0) { n = 2; cp = c & 0x1F; }
+    else { *width = 1; return 1; }
+
+    if (n > len) { *width = 1; return 1; }
+    for (size_t i = 1; i < n; i++) {
+        if ((p[i] & 0xC0) != 0x80) { *width = 1; return 1; }
+        cp = (cp << 6) | (p[i] & 0x3F);
+    }
+
+    *width = codepoint_width(cp);
+    return n;
+}
+
+
+size_t str_width_n(const char *s, size_t len) {
+    const unsigned char *p = (const unsigned char *)s;
+    const unsigned char *end = p + len;
+    size_t width = 0;
+    int w;
+
+    if (!s) return 0;
+
+    while (p < end) {
+        size_t run = ascii_run(p, end - p);
+        width += run;
+        p += run;
+        if (p >= end) break;
+
+        if (*p == 0x1B) {
+            p += escape_len(p, end - p);
+        } else {
+            p += glyph_len(p, end - p, &w);
+            width += w;
+        }
+    }
+    return width;
+}
+
+
+size_t str_width(const char *s) {
+    if (!s) return 0;
+
+    return str_width_n(s, strlen(s));
+}
+
+
+static int append(char **p, const char *end, const void *src, size_t n) {
+    if (n == 0) return 1;
+    if ((size_t)(end - *p) < n) return 0;
+    memcpy(*p, src, n);
+    *p += n;
+    return 1;
+}
+
+
+static int append_spaces(char **p, const char *end, size_t n) {
+    if ((size_t)(end - *p) < n) return 0;
+    memset(*p, ' ', n);
+    *p += n;
+    return 1;
+}
+
+
+size_t str_pad(char *dst, size_t size, const char *s, size_t width, TextAlign align) {
+    if (!dst || !s || size == 0) return 0;
+
+    size_t len = strlen(s);
+    size_t w = str_width_n(s, len);
+    size_t pad = (width > w) ? width - w : 0;
+    size_t left = (align == ALIGN_RIGHT) ? pad : (align == ALIGN_CENTER) ? pad / 2 : 0;
+    char *p = dst;
+    const char *end = dst + size - 1;
+
+    if (!append_spaces(&p, end, left)) return 0;
+    if (!append(&p, end, s, len)) return 0;
+    if (!append_spaces(&p, end, pad - left)) return 0;
+    *p = '\0';
+
+    return p - dst;
+}
+
+
+size_t str_truncate(char *dst, size_t size, const char *s, size_t width, const char *ellipsis) {
+    if (!dst || !s || size == 0) return 0;
+
+    size_t len = strlen(s);
+    char *p = dst;
+    const char *end = dst + size - 1;
+
+    if (str_width_n(s, len) <= width) {
+        if (!append(&p, end, s, len)) return 0;
+        *p = '\0';
+        return p - dst;
+    }
+
+    size_t ell_len = (ellipsis) ? strlen(ellipsis) : 0;
+    size_t ell_w = str_width_n(ellipsis, ell_len);
+    if (ell_w > width) {
+        ell_len = 0;
+        ell_w = 0;
+    }
+
+    const unsigned char *q = (const unsigned char *)s;
+    const unsigned char *q_end = q + len;
+    size_t used = 0;
+    int cut = 0;
+    int w;
+
+    while (q < q_end) {
+        size_t n;
+
+        if (*q == 0x1B) {
+            n = escape_len(q, q_end - q);
+            if (!append(&p, end, q, n)) return 0;
+        } else {
+            n = glyph_len(q, q_end - q, &w);
+            if (!cut && used + w <= width - ell_w) {
+                if (!append(&p, end, q, n)) return 0;
+                used += w;
+            } else if (!cut) {
+                cut = 1;
+                if (!append(&p, end, ellipsis, ell_len)) return 0;
+            }
+        }
+        q += n;
+    }
+    *p = '\0';
+
+    return p - dst;
+}
+
+
+char *str_fit(const char *s, size_t width, TextAlign align) {
+    if (!s) return NULL;
+
+    size_t tmp_size = strlen(s) + sizeof("…");
+    char *tmp = malloc(tmp_size);
+    if (!tmp) return NULL;
+
+    size_t tmp_len = str_truncate(tmp, tmp_size, s, width, "…");
+    size_t size = tmp_len + width + 1;
+    char *str = malloc(size);
+    if (!str) {free(tmp);return NULL;}
+
+    str_pad(str, size, tmp, width, align);
+    free(tmp);
+
+    gc_add(str);
+
+    return str;
+}
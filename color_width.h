@@ -0,0 +1,74 @@
+/**
+ * @file color_width.h
+ * @brief Display width measurement, padding and truncation of colored UTF-8 strings.
+ *
+ * Escape sequences (CSI such as "\033[31m", OSC, two-byte escapes) take no column,
+ * UTF-8 codepoints take one column, East-Asian wide glyphs two, combining marks zero.
+ * Pure-ASCII runs are measured 16 bytes at a time (SSE2) or 8 bytes at a time (SWAR).
+ * Defining COLOR_WIDTH_NO_SSE2 when building color_width.c selects the SWAR path on x86.
+ */
+
+#ifndef COLOR_WIDTH_H
+#define COLOR_WIDTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Horizontal alignment used by the padding helpers.
+ */
+typedef enum {
+    ALIGN_LEFT   = 0,
+    ALIGN_RIGHT  = 1,
+    ALIGN_CENTER = 2
+} TextAlign;
+
+/**
+ * @brief Column width of a single Unicode codepoint.
+ * @return 0 (control, combining), 1 (narrow) or 2 (East-Asian wide / fullwidth).
+ */
+int codepoint_width(uint32_t cp);
+
+/**
+ * @brief Display width of a NUL-terminated string, escape sequences excluded.
+ */
+size_t str_width(const char *s);
+
+/**
+ * @brief Display width of the first 'len' bytes of a string, escape sequences excluded.
+ */
+size_t str_width_n(const char *s, size_t len);
+
+/**
+ * @brief Pads a string with spaces up to 'width' columns.
+ * * Escape sequences are copied untouched; a string already wider than 'width' is copied as is.
+ * @param dst Destination buffer, NUL-terminated on success.
+ * @param size Size of dst.
+ * @return Number of bytes written (NUL excluded), or 0 if dst is too small.
+ */
+size_t str_pad(char *dst, size_t size, const char *s, size_t width, TextAlign align);
+
+/**
+ * @brief Cuts a string to at most 'width' columns, appending 'ellipsis' when something was cut.
+ * * Every escape sequence is kept, including those after the cut, so a trailing
+ * Style.RESET still applies. A wide glyph never gets split.
+ * @param ellipsis Marker such as "…" (counted in the width), or NULL.
+ * @return Number of bytes written (NUL excluded), or 0 if dst is too small.
+ */
+size_t str_truncate(char *dst, size_t size, const char *s, size_t width, const char *ellipsis);
+
+/**
+ * @brief Truncates (with "…") then pads a string to exactly 'width' columns.
+ * @return A string managed by the GC, or NULL on allocation failure.
+ */
+char *str_fit(const char *s, size_t width, TextAlign align);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COLOR_WIDTH_H */
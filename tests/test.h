@@ -0,0 +1,22 @@
+/**
+ * @file test.h
+ * @brief Minimal check macros shared by the tests (built with ASan/UBSan by `make test`).
+ */
+
+#ifndef COLOR_TEST_H
+#define COLOR_TEST_H
+
+#include <stdio.h>
+
+static int g_test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        g_test_failures++; \
+    } \
+} while (0)
+
+#define TEST_END() ((g_test_failures) ? (fprintf(stderr, "%d failure(s)\n", g_test_failures), 1) : 0)
+
+#endif /* COLOR_TEST_H */
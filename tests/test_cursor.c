@@ -0,0 +1,166 @@
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_vt.h"
+#include "test.h"
+
+#define ROWS 30
+#define COLS 100
+
+
+static t_cursor_pos pos(uint16_t row, uint16_t col) {
+    t_cursor_pos p = {row, col};
+    return p;
+}
+
+
+/* Exact bytes, and the cost query agrees */
+static int moves_with(t_cursor_pos from, t_cursor_pos to, const char *cells, const char *expected) {
+    char buf[256];
+    size_t cost = put_cursor_move(NULL, from, to, cells, (cells) ? strlen(cells) : 0);
+    size_t len = put_cursor_move(buf, from, to, cells, (cells) ? strlen(cells) : 0);
+
+    if (cost != len || len != strlen(expected) || memcmp(buf, expected, len) != 0) {
+        fprintf(stderr, "(%u,%u) -> (%u,%u): got \"", from.row, from.col, to.row, to.col);
+        for (size_t i = 0; i < len; i++) fprintf(stderr, (buf[i] < 0x20) ? "\\x%02X" : "%c", buf[i]);
+        fprintf(stderr, "\"\n");
+        return 0;
+    }
+    return 1;
+}
+
+
+static int moves(t_cursor_pos from, t_cursor_pos to, const char *expected) {
+    return moves_with(from, to, NULL, expected);
+}
+
+
+static void test_choices(void) {
+    /* Carriage return, backspaces, CUB vs CHA */
+    CHECK(moves(pos(5, 10), pos(5, 1), "\r"));
+    CHECK(moves(pos(5, 10), pos(5, 9), "\b"));
+    CHECK(moves(pos(5, 10), pos(5, 7), "\b\b\b"));
+    CHECK(moves(pos(5, 100), pos(5, 95), "\033[5D"));
+    CHECK(moves(pos(5, 10), pos(5, 6), "\033[6G"));  /* Ties keep CHA / CUP */
+    CHECK(moves(pos(5, 30), pos(5, 3), "\033[3G"));
+    CHECK(moves(pos(5, 300), pos(5, 150), "\033[150G"));
+
+    /* Line feeds (then CR) vs CUD */
+    CHECK(moves(pos(5, 10), pos(6, 1), "\n\r"));
+    CHECK(moves(pos(5, 10), pos(7, 1), "\n\n\r"));
+    CHECK(moves(pos(5, 10), pos(8, 1), "\033[8H"));
+    CHECK(moves(pos(5, 10), pos(6, 2), "\n\r\033[C"));
+    CHECK(moves(pos(5, 10), pos(6, 10), "\033[B"));
+    CHECK(moves(pos(5, 1), pos(25, 1), "\033[25H"));
+    CHECK(moves(pos(5, 40), pos(25, 40), "\033[20B"));
+
+    /* Vertical: CUU, VPA, or CUP when it is not longer */
+    CHECK(moves(pos(5, 10), pos(4, 10), "\033[A"));
+    CHECK(moves(pos(10, 1), pos(2, 1), "\033[2H"));
+    CHECK(moves(pos(900, 7), pos(8, 7), "\033[8d"));
+    CHECK(moves(pos(1, 1), pos(40, 100), "\033[40;100H"));
+    CHECK(moves(pos(7, 7), pos(1, 1), "\033[H"));
+    CHECK(moves(pos(7, 7), pos(1, 90), "\033[;90H"));
+
+    /* Large coordinates */
+    CHECK(moves(pos(1, 1), pos(65535, 65535), "\033[65535;65535H"));
+    CHECK(moves(pos(65535, 65535), pos(65535, 1), "\r"));
+    CHECK(moves(pos(65535, 65535), pos(1, 1), "\033[H"));
+    CHECK(moves(pos(65534, 65535), pos(65535, 65535), "\033[B"));
+
+    /* No move, invalid positions */
+    CHECK(moves(pos(3, 3), pos(3, 3), ""));
+    CHECK(put_cursor_move(NULL, pos(0, 3), pos(3, 3), NULL, 0) == 0);
+    CHECK(put_cursor_move(NULL, pos(3, 3), pos(3, 0), NULL, 0) == 0);
+    CHECK(cursor_move(pos(0, 1), pos(1, 1)) == NULL);
+    CHECK(strcmp(cursor_move(pos(3, 3), pos(3, 3)), "") == 0);
+    CHECK(strcmp(cursor_move(pos(5, 10), pos(7, 1)), "\n\n\r") == 0);
+}
+
+
+/* Known cells are reprinted when shorter than any sequence */
+static void test_reprint(void) {
+    const char *row = "hello world";
+
+    CHECK(moves_with(pos(3, 1), pos(3, 2), row, "h"));
+    CHECK(moves_with(pos(3, 2), pos(3, 5), row, "ell"));
+    CHECK(moves_with(pos(3, 12), pos(3, 14), row, "\033[2C"));
+    CHECK(moves_with(pos(3, 2), pos(3, 6), row, "\033[6G"));
+    CHECK(moves_with(pos(2, 8), pos(3, 3), row, "\n\rhe"));
+    CHECK(moves_with(pos(3, 30), pos(3, 3), row, "\rhe"));
+
+    /* Unknown or non-printable cells are not reprinted */
+    CHECK(moves_with(pos(3, 11), pos(3, 13), "h", "\033[2C"));
+    CHECK(moves_with(pos(3, 11), pos(3, 13), "0123456789a\tx", "\033[2C"));
+    CHECK(moves_with(pos(3, 1), pos(3, 2), "", "\033[C"));
+}
+
+
+/* Every emitted sequence, replayed from 'from', lands on 'to' without changing the grid */
+static void test_replay(void) {
+    static const uint16_t rows[] = {1, 2, 3, 9, 10, 11, 15, 29, 30};
+    static const uint16_t cols[] = {1, 2, 3, 7, 8, 9, 10, 50, 99, 100};
+    const size_t nb_rows = sizeof(rows) / sizeof(rows[0]);
+    const size_t nb_cols = sizeof(cols) / sizeof(cols[0]);
+    char line[COLS + 1], text[4 * COLS], buf[COLS + 64];
+    t_vt *vt = vt_new(ROWS, COLS);
+
+    for (int i = 0; i < COLS; i++) line[i] = (char)('!' + i % 90);
+    line[COLS] = '\0';
+
+    for (int onlcr = 0; onlcr < 2; onlcr++) {
+        for (size_t a = 0; a < nb_rows * nb_cols; a++) {
+            for (size_t b = 0; b < nb_rows * nb_cols; b++) {
+                t_cursor_pos from = pos(rows[a / nb_cols], cols[a % nb_cols]);
+                t_cursor_pos to = pos(rows[b / nb_cols], cols[b % nb_cols]);
+                const char *cells = (b & 1) ? line : NULL;
+
+                vt_reset(vt);
+                vt->onlcr = (unsigned char)onlcr;
+                for (uint16_t r = 1; r < ROWS; r++) vt_write(vt, line, COLS - 1), vt_write(vt, "\r\n", 2);
+                vt_write(vt, line, COLS - 1);
+
+                size_t n = put_cursor_cup(buf, from.row, from.col);
+                n += put_cursor_move(buf + n, from, to, cells, COLS);
+                vt_write(vt, buf, n);
+
+                t_cursor_pos at = vt_cursor(vt);
+                if (at.row != to.row || at.col != to.col) {
+                    fprintf(stderr, "(%u,%u) -> (%u,%u) landed on (%u,%u), onlcr %d\n",
+                            from.row, from.col, to.row, to.col, at.row, at.col, onlcr);
+                    CHECK(0);
+                }
+                CHECK(vt_row_text(vt, to.row, text, sizeof(text)) == COLS - 1);
+                CHECK(memcmp(text, line, COLS - 1) == 0);
+            }
+        }
+    }
+    vt_free(vt);
+}
+
+
+/* From the pending-wrap state (just printed the last column) a CR or an absolute move comes first */
+static void test_pending_wrap(void) {
+    t_vt *vt = vt_new(4, 10);
+    char buf[64];
+
+    vt_write(vt, "0123456789", 10);
+    CHECK(vt->wrap_pending);
+
+    size_t n = put_cursor_cup(buf, 1, 10);
+    n += put_cursor_move(buf + n, pos(1, 10), pos(1, 4), "0123456789", 10);
+    vt_write(vt, buf, n);
+    vt_write(vt, "x", 1);
+    CHECK(vt_cursor(vt).row == 1 && vt_cursor(vt).col == 5);
+    CHECK(vt_cell(vt, 1, 4)->ch == 'x');
+    vt_free(vt);
+}
+
+
+int main(void) {
+    test_choices();
+    test_reprint();
+    test_replay();
+    test_pending_wrap();
+    return TEST_END();
+}
@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_frame.h"
+#include "color_vt.h"
+#include "color_width.h"
+#include "test.h"
+
+#define ROWS 48
+#define COLS 100
+
+
+/* Wide, combining, control and plain glyphs, with runs of equal pens */
+static void fill(t_frame_cell *cells, uint16_t rows, uint16_t cols) {
+    static const uint32_t glyphs[] = {'a', 'Z', ' ', 0, 0x4E2D, 0x0301, 0x2580, 0x1F600, '\n', 0xE9};
+    uint32_t seed = 12345;
+
+    for (size_t i = 0; i < (size_t)rows * cols; i++) {
+        seed = seed * 1103515245u + 12345u;
+        cells[i].ch = glyphs[(seed >> 16) % 10];
+        cells[i].fg = (t_rgb){(uint8_t)(i / 7), (uint8_t)(seed >> 24), 3};
+        cells[i].bg = (t_rgb){9, (uint8_t)(i / 5), (uint8_t)(i % 2)};
+    }
+}
+
+
+/* frame_write() into a temp file, read back */
+static char *render(t_frame_pool *pool, const t_frame_cell *cells, uint16_t rows, uint16_t cols,
+                    t_cursor_pos origin, size_t *len) {
+    char path[] = "/tmp/color_frame_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return NULL;
+    unlink(path);
+
+    ssize_t n = frame_write(pool, fd, cells, rows, cols, origin);
+    char *buf = (n > 0) ? malloc((size_t)n) : NULL;
+    if (buf && pread(fd, buf, (size_t)n, 0) != n) {
+        free(buf);
+        buf = NULL;
+    }
+    close(fd);
+    *len = (size_t)n;
+    return buf;
+}
+
+
+static int same_pen(const t_vt_cell *cell, const t_frame_cell *src) {
+    uint32_t fg = (uint32_t)src->fg.r << 16 | (uint32_t)src->fg.g << 8 | src->fg.b;
+    uint32_t bg = (uint32_t)src->bg.r << 16 | (uint32_t)src->bg.g << 8 | src->bg.b;
+
+    return cell->pen.fg.kind == VT_COLOR_RGB && cell->pen.fg.value == fg
+        && cell->pen.bg.kind == VT_COLOR_RGB && cell->pen.bg.value == bg;
+}
+
+
+/* Replays the frame through the emulator: each source cell lands on its own column */
+static void check_cells(const char *out, size_t len, const t_frame_cell *cells, uint16_t rows, uint16_t cols,
+                        t_cursor_pos origin) {
+    t_vt *vt = vt_new(origin.row + rows - 1, origin.col + cols - 1);
+    vt_write(vt, out, len);
+
+    for (uint16_t y = 0; y < rows; y++) {
+        for (uint16_t x = 0; x < cols; x++) {
+            const t_frame_cell *src = &cells[(size_t)y * cols + x];
+            const t_vt_cell *cell = vt_cell(vt, origin.row + y, origin.col + x);
+            int width = codepoint_width(src->ch);
+            uint32_t expected = (width == 0 || (width == 2 && x + 1 == cols)) ? ' ' : src->ch;
+
+            if (!cell || cell->ch != expected || !same_pen(cell, src)) {
+                fprintf(stderr, "cell %u,%u: U+%04X, expected U+%04X\n", y, x, (cell) ? cell->ch : 0, expected);
+                CHECK(0);
+                vt_free(vt);
+                return;
+            }
+            /* Right half of a wide glyph, whatever the covered source cell held */
+            if (width == 2 && x + 1 < cols) {
+                x++;
+                cell = vt_cell(vt, origin.row + y, origin.col + x);
+                CHECK(cell->ch == 0 && same_pen(cell, src));
+            }
+        }
+    }
+    vt_free(vt);
+}
+
+
+static void test_threads(void) {
+    t_frame_cell *cells = malloc(sizeof(t_frame_cell) * ROWS * COLS);
+    t_cursor_pos origin = {2, 3};
+    size_t ref_len, len;
+
+    CHECK(ROWS * COLS >= FRAME_PARALLEL_MIN);
+    fill(cells, ROWS, COLS);
+
+    char *ref = render(NULL, cells, ROWS, COLS, origin, &ref_len);
+    CHECK(ref != NULL);
+    check_cells(ref, ref_len, cells, ROWS, COLS, origin);
+
+    for (unsigned threads = 1; threads <= 9; threads++) {
+        t_frame_pool *pool = frame_pool_new(threads);
+        CHECK(pool != NULL);
+
+        for (int round = 0; round < 2; round++) {
+            char *out = render(pool, cells, ROWS, COLS, origin, &len);
+            if (!out || len != ref_len || memcmp(out, ref, len) != 0) {
+                fprintf(stderr, "%u threads, round %d\n", threads, round);
+                CHECK(0);
+            }
+            free(out);
+        }
+        frame_pool_free(pool);
+    }
+
+    /* More threads than rows */
+    t_frame_pool *pool = frame_pool_new(FRAME_MAX_THREADS);
+    char *out = render(pool, cells, ROWS, COLS, origin, &len);
+    CHECK(out && len == ref_len && memcmp(out, ref, len) == 0);
+    free(out);
+    frame_pool_free(pool);
+
+    free(ref);
+    free(cells);
+}
+
+
+/* Small frames reuse the pool's buffer across sizes */
+static void test_small(void) {
+    t_frame_cell cells[6 * 9];
+    t_frame_pool *pool = frame_pool_new(2);
+    t_cursor_pos origin = {1, 1};
+    size_t len, ref_len;
+
+    fill(cells, 6, 9);
+    for (uint16_t rows = 1; rows <= 6; rows++) {
+        char *ref = render(NULL, cells, rows, 9, origin, &ref_len);
+        char *out = render(pool, cells, rows, 9, origin, &len);
+
+        CHECK(ref && out && len == ref_len && memcmp(out, ref, len) == 0);
+        check_cells(out, len, cells, rows, 9, origin);
+        free(ref);
+        free(out);
+    }
+    frame_pool_free(pool);
+
+    /* A wide glyph covers the next cell, and prints a space in the last column */
+    t_frame_cell row[3] = {{'a', {1, 2, 3}, {4, 5, 6}}, {0x4E2D, {1, 2, 3}, {4, 5, 6}}, {0x4E2D, {1, 2, 3}, {4, 5, 6}}};
+    char *out = render(NULL, row, 1, 3, origin, &len);
+    t_vt *vt = vt_new(1, 3);
+    vt_write(vt, out, len);
+    CHECK(vt_cell(vt, 1, 1)->ch == 'a' && vt_cell(vt, 1, 2)->ch == 0x4E2D && vt_cell(vt, 1, 3)->ch == 0);
+    vt_free(vt);
+    free(out);
+
+    row[0].ch = 0x4E2D;
+    row[1].ch = 'x';
+    row[2].ch = 0x4E2D;
+    out = render(NULL, row, 1, 3, origin, &len);
+    vt = vt_new(1, 3);
+    vt_write(vt, out, len);
+    CHECK(vt_cell(vt, 1, 1)->ch == 0x4E2D && vt_cell(vt, 1, 2)->ch == 0 && vt_cell(vt, 1, 3)->ch == ' ');
+    vt_free(vt);
+    free(out);
+}
+
+
+int main(void) {
+    test_threads();
+    test_small();
+    return TEST_END();
+}
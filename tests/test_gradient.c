@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "test.h"
+
+
+static int near(t_rgb a, t_rgb b) {
+    return abs(a.r - b.r) <= 1 && abs(a.g - b.g) <= 1 && abs(a.b - b.b) <= 1;
+}
+
+
+/* Sizes where (n - 1) divides (nb_stops - 1) << 32 used to read stops[nb_stops] */
+static void test_endpoints(GradientSpace space) {
+    const t_rgb ref[5] = {{0, 0, 255}, {0, 255, 0}, {255, 0, 0}, {255, 255, 255}, {10, 20, 30}};
+
+    for (size_t nb_stops = 1; nb_stops <= 5; nb_stops++) {
+        /* Exact-size heap copy so ASan sees any read past the last stop */
+        t_rgb *stops = malloc(nb_stops * sizeof(t_rgb));
+        memcpy(stops, ref, nb_stops * sizeof(t_rgb));
+
+        for (size_t n = 1; n <= 70; n++) {
+            t_rgb *out = malloc(n * sizeof(t_rgb));
+            gradient_fill(out, n, stops, nb_stops, space);
+
+            CHECK(near(out[0], stops[0]));
+            if (n > 1) CHECK(near(out[n - 1], stops[nb_stops - 1]));
+            free(out);
+        }
+        free(stops);
+    }
+}
+
+
+static void test_render(void) {
+    t_rgb *stops = malloc(2 * sizeof(t_rgb));
+    stops[0] = (t_rgb){0, 0, 0};
+    stops[1] = (t_rgb){255, 255, 255};
+
+    const size_t sizes[] = {2, 3, 5, 9, 17, 257, 1025};
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        size_t n = sizes[k];
+        size_t size = gradient_size(n, GRADIENT_DEPTH_24, " ");
+        char *dst = malloc(size);
+
+        CHECK(gradient_render(dst, size, n, stops, 2, GRADIENT_SPACE_RGB, GRADIENT_DEPTH_24, COLOR_LAYER_BACK, " ") > 0);
+
+        char last[32];
+        size_t len = put_color24(last, COLOR_LAYER_BACK, 255, 255, 255);
+        last[len++] = ' ';
+        CHECK(strlen(dst) >= len && memcmp(dst + strlen(dst) - len, last, len) == 0);
+        free(dst);
+    }
+    free(stops);
+}
+
+
+int main(void) {
+    test_endpoints(GRADIENT_SPACE_RGB);
+    test_endpoints(GRADIENT_SPACE_OKLAB);
+    test_render();
+    return TEST_END();
+}
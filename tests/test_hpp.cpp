@@ -0,0 +1,82 @@
+/* Compile-time sequences of color_lib.hpp against what the C library produces at runtime */
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "color_lib.hpp"
+#include "test.h"
+
+
+static bool same(std::string_view cpp, const char *c) {
+    return c && cpp == std::string_view(c);
+}
+
+
+static void test_dynamic() {
+    CHECK(same(color::fg<0, 0, 0>, fore_color24(0, 0, 0)));
+    CHECK(same(color::fg<255, 128, 0>, fore_color24(255, 128, 0)));
+    CHECK(same(color::fg<9, 99, 100>, fore_color24(9, 99, 100)));
+    CHECK(same(color::bg<1, 22, 255>, back_color24(1, 22, 255)));
+    CHECK(same(color::ul<10, 0, 200>, underline_color24(10, 0, 200)));
+
+    CHECK(same(color::fg8<0>, fore_color8(0)));
+    CHECK(same(color::fg8<196>, fore_color8(196)));
+    CHECK(same(color::bg8<7>, back_color8(7)));
+    CHECK(same(color::bg8<42>, back_color8(42)));
+    CHECK(same(color::bg8<255>, back_color8(255)));
+    CHECK(same(color::ul8<99>, underline_color8(99)));
+
+    CHECK(same(color::sgr<1>, custom_code(1)));
+    CHECK(same(color::sgr<107>, custom_code(107)));
+}
+
+
+static void test_tables() {
+    const std::string_view fore[NB_FORE_COLORS] = {
+        color::fore::black, color::fore::red, color::fore::green, color::fore::yellow,
+        color::fore::blue, color::fore::magenta, color::fore::cyan, color::fore::white,
+        color::fore::bright_black, color::fore::bright_red, color::fore::bright_green, color::fore::bright_yellow,
+        color::fore::bright_blue, color::fore::bright_magenta, color::fore::bright_cyan, color::fore::bright_white
+    };
+    const std::string_view back[NB_BACK_COLORS] = {
+        color::back::black, color::back::red, color::back::green, color::back::yellow,
+        color::back::blue, color::back::magenta, color::back::cyan, color::back::white,
+        color::back::bright_black, color::back::bright_red, color::back::bright_green, color::back::bright_yellow,
+        color::back::bright_blue, color::back::bright_magenta, color::back::bright_cyan, color::back::bright_white
+    };
+
+    for (int i = 0; i < NB_FORE_COLORS; i++) CHECK(same(fore[i], Fore.array[i]));
+    for (int i = 0; i < NB_BACK_COLORS; i++) CHECK(same(back[i], Back.array[i]));
+
+    CHECK(same(color::style::reset, Style.RESET));
+    CHECK(same(color::style::bold, Style.BOLD));
+    CHECK(same(color::style::dim, Style.DIM));
+    CHECK(same(color::style::italic, Style.ITALIC));
+    CHECK(same(color::style::underline, Style.UNDERLINE));
+    CHECK(same(color::style::blink, Style.BLINK));
+    CHECK(same(color::style::blink_speed, Style.BLINK_SPEED));
+    CHECK(same(color::style::reverse, Style.REVERSE));
+    CHECK(same(color::style::hidden, Style.HIDDEN));
+    CHECK(same(color::style::strikethrough, Style.STRIKETHROUGH));
+    CHECK(same(color::style::underline_double, Style.UNDERLINE_DOUBLE));
+}
+
+
+static void test_writers() {
+    std::string out;
+
+    color::append_rgb(out, COLOR_LAYER_FORE, 12, 34, 56);
+    color::append_8(out, COLOR_LAYER_BACK, 200);
+    CHECK(out == std::string(fore_color24(12, 34, 56)) + back_color8(200));
+}
+
+
+int main() {
+    /* The compile-time sequences use the default prefix */
+    init_color(NULL, 1, 0, 0, COLOR_FLAG_INIT_ALL);
+
+    test_dynamic();
+    test_tables();
+    test_writers();
+    return TEST_END();
+}
@@ -0,0 +1,103 @@
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_html.h"
+#include "test.h"
+
+
+typedef struct s_golden {
+    HtmlStyleMode mode;
+    const char *in;
+    const char *out;
+} t_golden;
+
+
+static const t_golden GOLDEN[] = {
+    /* Escaping */
+    {HTML_STYLE_CLASSES, "plain <a> & \"q\" 'x'", "plain &lt;a&gt; &amp; &quot;q&quot; &#39;x&#39;"},
+    {HTML_STYLE_CLASSES, "tab\tnl\nbell\007cr\r", "tab\tnl\nbellcr"},
+
+    /* SGR and reset */
+    {HTML_STYLE_CLASSES, "\033[1;31mred\033[0m done", "<span class=\"ansi-fg1 ansi-bold\">red</span> done"},
+    {HTML_STYLE_INLINE, "\033[1;31mred\033[0m done", "<span style=\"color:#cd0000;font-weight:bold\">red</span> done"},
+    {HTML_STYLE_CLASSES, "\033[31mA\033[mB\033[;32mC", "<span class=\"ansi-fg1\">A</span>B<span class=\"ansi-fg2\">C</span>"},
+    {HTML_STYLE_INLINE, "\033[4;9mx\033[7my",
+     "<span style=\"text-decoration-line:underline line-through\">x</span>"
+     "<span style=\"color:var(--ansi-bg,#000);background-color:var(--ansi-fg,#fff);"
+     "text-decoration-line:underline line-through\">y</span>"},
+
+    /* 256 colors and RGB */
+    {HTML_STYLE_CLASSES, "\033[38;5;196mA\033[48;5;21mB\033[m",
+     "<span class=\"ansi-fg196\">A</span><span class=\"ansi-fg196 ansi-bg21\">B</span>"},
+    {HTML_STYLE_INLINE, "\033[38;5;196mA\033[48;2;1;2;3mB\033[m",
+     "<span style=\"color:#ff0000\">A</span><span style=\"color:#ff0000;background-color:#010203\">B</span>"},
+    {HTML_STYLE_CLASSES, "\033[38;2;255;128;0mrgb\033[39m x", "<span style=\"color:#ff8000\">rgb</span> x"},
+
+    /* Same pen, other sequences and strings: no new span */
+    {HTML_STYLE_CLASSES, "\033[31mA\033[31mB\033[2J\033]0;title\007C\033[?25lD\033[?1m",
+     "<span class=\"ansi-fg1\">ABCD</span>"},
+};
+
+#define NB_GOLDEN (sizeof(GOLDEN) / sizeof(GOLDEN[0]))
+
+
+/* Converts 'in' in chunks of 'chunk' bytes */
+static size_t convert(HtmlStyleMode mode, const char *in, size_t chunk, char *out, size_t size) {
+    t_html_conv conv;
+    size_t len = strlen(in);
+    size_t done = 0;
+    size_t n = 0;
+
+    html_init(&conv, mode);
+    while (done < len) {
+        size_t step = (len - done < chunk) ? len - done : chunk;
+        size_t off = 0;
+        while (off < step) {
+            size_t used;
+            n += html_convert(&conv, in + done + off, step - off, &used, out + n, size - n);
+            off += used;
+        }
+        done += step;
+    }
+    n += html_finish(&conv, out + n, size - n);
+    out[n] = '\0';
+    return n;
+}
+
+
+static void test_golden(void) {
+    char out[4096];
+
+    for (size_t i = 0; i < NB_GOLDEN; i++) {
+        const t_golden *g = &GOLDEN[i];
+        size_t len = strlen(g->in);
+
+        /* Whole input, then every chunk size down to one byte at a time */
+        for (size_t chunk = len; chunk >= 1; chunk--) {
+            convert(g->mode, g->in, chunk, out, sizeof(out));
+            if (strcmp(out, g->out) != 0) {
+                fprintf(stderr, "golden %zu, chunks of %zu: %s\n", i, chunk, out);
+                CHECK(0);
+                break;
+            }
+        }
+    }
+}
+
+
+static void test_small_output(void) {
+    t_html_conv conv;
+    char out[HTML_SPAN_MAX];
+    size_t used;
+
+    html_init(&conv, HTML_STYLE_CLASSES);
+    CHECK(html_convert(&conv, "x", 1, &used, out, HTML_SPAN_MAX - 1) == 0);
+    CHECK(used == 0);
+}
+
+
+int main(void) {
+    test_golden();
+    test_small_output();
+    return TEST_END();
+}
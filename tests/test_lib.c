@@ -0,0 +1,92 @@
+#define _POSIX_C_SOURCE 200809L
+#include <string.h>
+
+#include "color_lib.h"
+#include "test.h"
+
+
+typedef struct s_table {
+    const char *name;
+    const char (*array)[COLOR_STR_SIZE];
+    size_t count;
+} t_table;
+
+#define TABLE(t) {#t, t.array, sizeof(t.array) / sizeof(t.array[0])}
+
+
+/* Every entry: starts with the prefix, no NUL inside, COLOR_LEN() == strlen() */
+static void check_tables(const char *esc) {
+    const t_table tables[] = {
+        TABLE(Fore), TABLE(Back), TABLE(Style), TABLE(Disable), TABLE(Default),
+        TABLE(Font), TABLE(Misc), TABLE(Cursor), TABLE(Screen)
+    };
+    size_t esc_len = strlen(esc);
+
+    for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+        for (size_t i = 0; i < tables[t].count; i++) {
+            const char *entry = tables[t].array[i];
+
+            if (COLOR_LEN(entry) != strlen(entry) || strncmp(entry, esc, esc_len) != 0
+                || color_seq(entry).len != COLOR_LEN(entry)) {
+                fprintf(stderr, "%s[%zu] with prefix of %zu bytes\n", tables[t].name, i, esc_len);
+                CHECK(0);
+            }
+        }
+    }
+}
+
+
+static int same(const char *gc, const char *buf, size_t len) {
+    return gc && strlen(gc) == len && memcmp(gc, buf, len) == 0;
+}
+
+
+/* The put_* writers give the bytes of the GC generators */
+static void check_generators(void) {
+    static const uint16_t values[] = {1, 2, 9, 10, 99, 100, 999, 1000, 9999, 10000, 65535};
+    char buf[COLOR_ESC_MAX + COLOR_SEQ_BODY_MAX];
+
+    CHECK(COLOR_SEQ_MAX <= sizeof(buf));
+    for (int code = 0; code < 256; code++) {
+        CHECK(same(custom_code((unsigned char)code), buf, put_custom_code(buf, (unsigned char)code)));
+    }
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        uint16_t n = values[i];
+
+        CHECK(same(cursor_cup(n, values[10 - i]), buf, put_cursor_cup(buf, n, values[10 - i])));
+        CHECK(same(cursor_cuu(n), buf, put_cursor_cuu(buf, n)));
+        CHECK(same(cursor_cud(n), buf, put_cursor_cud(buf, n)));
+        CHECK(same(cursor_cuf(n), buf, put_cursor_cuf(buf, n)));
+        CHECK(same(cursor_cub(n), buf, put_cursor_cub(buf, n)));
+    }
+    for (int c = 0; c < 256; c++) {
+        CHECK(same(fore_color8((uint8_t)c), buf, put_color8(buf, COLOR_LAYER_FORE, (uint8_t)c)));
+        CHECK(same(back_color8((uint8_t)c), buf, put_color8(buf, COLOR_LAYER_BACK, (uint8_t)c)));
+        CHECK(same(underline_color8((uint8_t)c), buf, put_color8(buf, COLOR_LAYER_UNDERLINE, (uint8_t)c)));
+        CHECK(same(fore_color24((uint8_t)c, 0, 255 - c), buf, put_color24(buf, COLOR_LAYER_FORE, (uint8_t)c, 0, 255 - c)));
+        CHECK(same(back_color24(255, (uint8_t)c, 7), buf, put_color24(buf, COLOR_LAYER_BACK, 255, (uint8_t)c, 7)));
+    }
+}
+
+
+int main(void) {
+    check_tables("\033");
+    check_generators();
+
+    /* Longest accepted prefix, then a rejected one */
+    CHECK(init_color("\\u001b[\\", 0, 0, 0, COLOR_FLAG_INIT_DEFAULT) == 1);
+    CHECK(get_ansi_esc_len() == COLOR_ESC_MAX);
+    check_tables("\\u001b[\\");
+    check_generators();
+
+    CHECK(init_color("\\u0000001b", 0, 0, 0, COLOR_FLAG_INIT_DEFAULT) == 0);
+    CHECK(strcmp(get_ansi_esc_char(), "\033") == 0);
+    check_tables("\033");
+
+    CHECK(init_color("\\e", 0, 0, 0, COLOR_FLAG_INIT_DEFAULT) == 1);
+    check_tables("\\e");
+    check_generators();
+
+    init_color(NULL, 0, 0, 0, COLOR_FLAG_INIT_DEFAULT);
+    return TEST_END();
+}
@@ -0,0 +1,84 @@
+#define _POSIX_C_SOURCE 200809L
+#include <pty.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_log.h"
+#include "test.h"
+
+
+/* Reads what one log line wrote to 'fd' */
+static size_t read_line(int fd, char *buf, size_t size) {
+    ssize_t n = read(fd, buf, size - 1);
+
+    buf[(n < 0) ? 0 : n] = '\0';
+    return (n < 0) ? 0 : (size_t)n;
+}
+
+
+static void test_prefixes(int in, int out) {
+    char buf[256];
+
+    /* Only the default tables: the prefixes do not depend on Fore/Style */
+    init_color(NULL, 1, 1, 0, COLOR_FLAG_INIT_DEFAULT);
+    log_set_fd(out);
+
+    log_set_color(0);
+    LOG_WARN("disk %d%%", 93);
+    read_line(in, buf, sizeof(buf));
+    CHECK(strcmp(buf, "[WARN]  disk 93%\n") == 0);
+
+    log_set_color(1);
+    LOG_ERROR("failed");
+    read_line(in, buf, sizeof(buf));
+    CHECK(strcmp(buf, "\033[1m\033[91m[ERROR]\033[0m failed\n") == 0);
+
+    LOG_INFO("ok");
+    read_line(in, buf, sizeof(buf));
+    CHECK(strcmp(buf, "\033[32m[INFO] \033[0m ok\n") == 0);
+}
+
+
+/* Colors follow isatty() of the new fd, until log_set_color() overrides it */
+static int test_fd_color(int in, int out) {
+    int master, slave;
+    char buf[256];
+
+    if (openpty(&master, &slave, NULL, NULL, NULL) < 0) return 0;
+
+    log_set_fd(slave);
+    LOG_INFO("tty");
+    read_line(master, buf, sizeof(buf));
+    CHECK(strncmp(buf, "\033[32m[INFO] ", 12) == 0);
+
+    log_set_fd(out);
+    LOG_INFO("pipe");
+    read_line(in, buf, sizeof(buf));
+    CHECK(strcmp(buf, "[INFO]  pipe\n") == 0);
+
+    log_set_color(1);
+    log_set_fd(out);
+    LOG_INFO("forced");
+    read_line(in, buf, sizeof(buf));
+    CHECK(strncmp(buf, "\033[32m", 5) == 0);
+
+    close(master);
+    close(slave);
+    return 1;
+}
+
+
+int main(void) {
+    int fds[2];
+
+    if (pipe(fds) < 0) return 1;
+    log_set_time_format(LOG_TIME_NONE);
+
+    test_fd_color(fds[0], fds[1]);
+    test_prefixes(fds[0], fds[1]);
+
+    close(fds[0]);
+    close(fds[1]);
+    return TEST_END();
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_parse.h"
+#include "test.h"
+#include "color_names.h"
+
+#define NB_TEST_NAMES (sizeof(TEST_COLOR_NAMES) / sizeof(TEST_COLOR_NAMES[0]))
+
+
+static int parses_to(const char *spec, uint8_t r, uint8_t g, uint8_t b) {
+    t_rgb rgb;
+
+    return color_parse(spec, &rgb) && rgb.r == r && rgb.g == g && rgb.b == b;
+}
+
+
+static void test_percentages(void) {
+    CHECK(parses_to("rgb(100%, 0%, 50%)", 255, 0, 128));
+    CHECK(parses_to("rgb(12.5%,0,0)", 32, 0, 0));
+    CHECK(parses_to("rgb(99.999%,0,0)", 255, 0, 0));
+
+    /* Saturated before scaling, no overflow back to small values */
+    CHECK(parses_to("rgb(99999999%,0,0)", 255, 0, 0));
+    CHECK(parses_to("rgb(4294968%,1000%,100.5%)", 255, 255, 255));
+    CHECK(parses_to("rgb(429497.999%,0,0)", 255, 0, 0));
+}
+
+
+static void test_forms(void) {
+    CHECK(parses_to("#FF8000", 255, 128, 0));
+    CHECK(parses_to("#f80", 255, 136, 0));
+    CHECK(parses_to("rgb(1, 2, 3)", 1, 2, 3));
+    CHECK(parses_to("rgb(300, 0, 0)", 255, 0, 0));
+    CHECK(parses_to("  coral ", 255, 127, 80));
+    CHECK(!color_parse("rgb(1, 2)", NULL));
+    CHECK(!color_parse("#12345", NULL));
+    CHECK(!color_parse("not-a-color", NULL));
+}
+
+
+static int is_name(const char *key) {
+    for (size_t i = 0; i < NB_TEST_NAMES; i++) {
+        if (strcmp(TEST_COLOR_NAMES[i].name, key) == 0) return 1;
+    }
+    return 0;
+}
+
+
+/* Every name resolves to its color, through every accepted spelling and back through hex */
+static void test_names(void) {
+    char spec[64];
+    t_rgb rgb;
+
+    for (size_t i = 0; i < NB_TEST_NAMES; i++) {
+        const char *name = TEST_COLOR_NAMES[i].name;
+        uint32_t v = TEST_COLOR_NAMES[i].rgb;
+        uint8_t r = (uint8_t)(v >> 16), g = (uint8_t)(v >> 8), b = (uint8_t)v;
+
+        CHECK(parses_to(name, r, g, b));
+        CHECK(color_lookup_name(name, strlen(name), &rgb) && rgb.r == r && rgb.g == g && rgb.b == b);
+
+        /* Upper case, separators */
+        size_t n = 0;
+        for (size_t k = 0; name[k]; k++) {
+            if (k == 4) spec[n++] = "-_ "[i % 3];
+            spec[n++] = (k % 2) ? name[k] - 'a' + 'A' : name[k];
+        }
+        spec[n] = '\0';
+        if (!parses_to(spec, r, g, b)) {
+            fprintf(stderr, "%s as \"%s\"\n", name, spec);
+            CHECK(0);
+        }
+
+        snprintf(spec, sizeof(spec), "#%02x%02X%02x", r, g, b);
+        CHECK(parses_to(spec, r, g, b));
+    }
+}
+
+
+/* One letter dropped, added or changed: rejected unless that spells another name */
+static void test_near_misses(void) {
+    char key[64];
+
+    for (size_t i = 0; i < NB_TEST_NAMES; i++) {
+        const char *name = TEST_COLOR_NAMES[i].name;
+        size_t len = strlen(name);
+
+        for (size_t k = 0; k <= len; k++) {
+            if (k < len) {
+                memcpy(key, name, k);
+                memcpy(key + k, name + k + 1, len - k);
+                CHECK(color_lookup_name(key, len - 1, NULL) == is_name(key));
+
+                memcpy(key, name, len + 1);
+                key[k] = (key[k] == 'z') ? 'a' : key[k] + 1;
+                CHECK(color_lookup_name(key, len, NULL) == is_name(key));
+            }
+            memcpy(key, name, k);
+            key[k] = 'e';
+            memcpy(key + k + 1, name + k, len - k + 1);
+            CHECK(color_lookup_name(key, len + 1, NULL) == is_name(key));
+        }
+
+        snprintf(key, sizeof(key), "%s2", name);
+        CHECK(!color_parse(key, NULL));
+    }
+
+    CHECK(!color_lookup_name("", 0, NULL));
+    CHECK(!color_lookup_name("- _", 3, NULL));
+    CHECK(!color_lookup_name("lightgoldenrodyellowxxxxx", 25, NULL));
+    CHECK(!color_lookup_name(NULL, 4, NULL));
+}
+
+
+int main(void) {
+    test_percentages();
+    test_forms();
+    test_names();
+    test_near_misses();
+    return TEST_END();
+}
@@ -0,0 +1,283 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_remap.h"
+#include "test.h"
+
+#define OUT_SIZE 4096
+
+
+typedef struct s_out {
+    char buf[OUT_SIZE];
+    size_t len;
+} t_out;
+
+
+typedef struct s_golden {
+    const char *in;
+    const char *expected;
+} t_golden;
+
+
+static int out_writer(void *ctx, const char *data, size_t len) {
+    t_out *o = ctx;
+
+    if (o->len + len > OUT_SIZE) return 0;
+    memcpy(o->buf + o->len, data, len);
+    o->len += len;
+    return 1;
+}
+
+
+/* Feeds 'in' as chunks cut at 'cuts' (sorted offsets), compares with 'expected' */
+static int filters_to(const t_remap_lut *lut, const char *in, size_t len, const size_t *cuts, size_t nb_cuts,
+                      const char *expected, size_t expected_len) {
+    t_remap remap;
+    t_out out = {.len = 0};
+    size_t from = 0;
+
+    remap_init(&remap, lut);
+    for (size_t i = 0; i <= nb_cuts; i++) {
+        size_t to = (i < nb_cuts) ? cuts[i] : len;
+        if (!remap_feed(&remap, in + from, to - from, out_writer, &out)) return 0;
+        from = to;
+    }
+    if (!remap_finish(&remap, out_writer, &out)) return 0;
+
+    return out.len == expected_len && memcmp(out.buf, expected, expected_len) == 0;
+}
+
+
+/* Whole, split at every byte, and one byte at a time */
+static void check_golden(const t_remap_lut *lut, const char *in, size_t len, const char *expected, size_t expected_len) {
+    size_t cuts[OUT_SIZE];
+
+    if (!filters_to(lut, in, len, NULL, 0, expected, expected_len)) {
+        fprintf(stderr, "whole: \"%s\"\n", in + 1);
+        CHECK(0);
+        return;
+    }
+    for (size_t cut = 0; cut <= len; cut++) {
+        if (!filters_to(lut, in, len, &cut, 1, expected, expected_len)) {
+            fprintf(stderr, "split at %zu: \"%s\"\n", cut, in + 1);
+            CHECK(0);
+            return;
+        }
+    }
+    for (size_t i = 0; i < len; i++) cuts[i] = i + 1;
+    if (!filters_to(lut, in, len, cuts, len, expected, expected_len)) {
+        fprintf(stderr, "byte by byte: \"%s\"\n", in + 1);
+        CHECK(0);
+    }
+}
+
+
+static void check_table(const t_remap_lut *lut, const t_golden *cases, size_t nb_cases) {
+    for (size_t i = 0; i < nb_cases; i++) {
+        check_golden(lut, cases[i].in, strlen(cases[i].in), cases[i].expected, strlen(cases[i].expected));
+    }
+}
+
+
+static t_remap_target to_rgb(uint8_t r, uint8_t g, uint8_t b) {
+    t_remap_target t = {REMAP_TO_RGB, 0, {r, g, b}};
+    return t;
+}
+
+
+static t_remap_target to_index(RemapKind kind, uint8_t index) {
+    t_remap_target t = {(uint8_t)kind, index, {0, 0, 0}};
+    return t;
+}
+
+
+static void test_16_to_rgb(void) {
+    static const t_golden cases[] = {
+        {"\033[31mred\033[0m", "\033[38;2;200;0;0mred\033[0m"},
+        {"\033[41m", "\033[48;2;200;0;0m"},
+        {"\033[91m", "\033[38;2;255;80;80m"},
+        {"a\033[1;31;44mb", "a\033[1;38;2;200;0;0;44mb"},
+        {"\033[32m\033[m", "\033[32m\033[m"},
+        {"\033[;31m", "\033[0;38;2;200;0;0m"},
+        {"\033[38;5;1m", "\033[38;5;1m"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.base[1] = to_rgb(200, 0, 0);
+    lut.base[9] = to_rgb(255, 80, 80);
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+static void test_256_to_256(void) {
+    static const t_golden cases[] = {
+        {"\033[38;5;196mx", "\033[38;5;160mx"},
+        {"\033[48;5;196m", "\033[48;5;160m"},
+        {"\033[38;5;197m", "\033[38;5;197m"},
+        {"\033[38;5;300m", "\033[38;5;300m"},
+        {"\033[1;38;5;196;48;5;196;4m", "\033[1;38;5;160;48;5;160;4m"},
+        {"\033[38;5m", "\033[38;5m"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.palette[196] = to_index(REMAP_TO_256, 160);
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+static void test_rgb_to_nearest(void) {
+    static const t_golden cases[] = {
+        {"\033[38;2;255;0;0m", "\033[38;5;196m"},
+        {"\033[48;2;0;0;0m", "\033[48;5;16m"},
+        {"\033[38;2;300;0;0m", "\033[38;5;196m"},
+        {"\033[38;2;0;0;255m", "\033[38;2;1;2;3m"},
+        {"\033[1;38;2;128;128;128;22m", "\033[1;38;5;244;22m"},
+        {"\033[38;2;1;2m", "\033[38;2;1;2m"},
+        {"\033[31m", "\033[31m"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.rgb_to_256 = 1;
+    /* The nearest entry goes through the palette table too */
+    lut.palette[21] = to_rgb(1, 2, 3);
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+/* Light theme: black and white swapped, red brightened, palette 1 shown as base blue */
+static void test_theme_swap(void) {
+    static const t_golden cases[] = {
+        {"\033[30;47m", "\033[37;40m"},
+        {"\033[31m", "\033[91m"},
+        {"\033[97;100m", "\033[97;100m"},
+        {"\033[38;5;1m", "\033[34m"},
+        {"\033[48;5;1m", "\033[44m"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.base[0] = to_index(REMAP_TO_16, 7);
+    lut.base[7] = to_index(REMAP_TO_16, 0);
+    lut.base[1] = to_index(REMAP_TO_16, 9);
+    lut.palette[1] = to_index(REMAP_TO_16, 4);
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+/* 58 has no 16-color form: base targets become 58;5;n */
+static void test_underline(void) {
+    static const t_golden cases[] = {
+        {"\033[58;5;9m", "\033[58;5;12m"},
+        {"\033[58;5;21m", "\033[58;2;1;2;3m"},
+        {"\033[4;58;5;9;59m", "\033[4;58;5;12;59m"},
+        {"\033[58;2;0;0;255m", "\033[58;2;1;2;3m"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.rgb_to_256 = 1;
+    lut.palette[9] = to_index(REMAP_TO_16, 12);
+    lut.palette[21] = to_rgb(1, 2, 3);
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+/* Private, colon, OSC, non-SGR and cancelled sequences are never rewritten */
+static void test_pass_through(void) {
+    static const t_golden cases[] = {
+        {"\033[?25h\033[?31m", "\033[?25h\033[?31m"},
+        {"\033[>31m", "\033[>31m"},
+        {"\033[38:5:196m\033[4:3m", "\033[38:5:196m\033[4:3m"},
+        {"\033[38;2::255:0:0m", "\033[38;2::255:0:0m"},
+        {"\033]0;31m title\007x", "\033]0;31m title\007x"},
+        {"\033]8;;http://x/31m\033\\link", "\033]8;;http://x/31m\033\\link"},
+        {"\033[31H\033[31;1r", "\033[31H\033[31;1r"},
+        {"\033[31\nm", "\033[31\nm"},
+        {"\033\033[31m", "\033\033[91m"},
+        {"\0337\033(B", "\0337\033(B"},
+        {"plain text", "plain text"},
+        {"\033[31", "\033[31"},
+        {"\033", "\033"}
+    };
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.base[1] = to_index(REMAP_TO_16, 9);
+    lut.palette[196] = to_index(REMAP_TO_256, 160);
+    lut.rgb_to_256 = 1;
+    check_table(&lut, cases, sizeof(cases) / sizeof(cases[0]));
+}
+
+
+/* Longer than REMAP_SEQ_MAX or REMAP_MAX_PARAMS: passed through as is */
+static void test_overflow(void) {
+    char in[600], expected[600];
+    t_remap_lut lut;
+    size_t n;
+
+    remap_lut_init(&lut);
+    lut.base[1] = to_index(REMAP_TO_16, 9);
+
+    /* Leading zeros: one parameter, 31 */
+    for (size_t zeros = REMAP_SEQ_MAX - 8; zeros <= REMAP_SEQ_MAX - 2; zeros++) {
+        n = (size_t)snprintf(in, sizeof(in), "\033[%0*dm", (int)zeros + 2, 31);
+        int fits = n <= REMAP_SEQ_MAX;
+        if (fits) snprintf(expected, sizeof(expected), "\033[91m");
+        else memcpy(expected, in, n + 1);
+        check_golden(&lut, in, n, expected, strlen(expected));
+    }
+
+    n = 0;
+    for (int i = 0; i < REMAP_MAX_PARAMS; i++) n += (size_t)snprintf(in + n, sizeof(in) - n, "%s", (i) ? ";1" : "\033[1");
+    snprintf(in + n, sizeof(in) - n, ";31m");
+    check_golden(&lut, in, strlen(in), in, strlen(in));
+
+    memcpy(expected, in, n);
+    snprintf(in + n - 2, sizeof(in) - n + 2, ";31m");
+    snprintf(expected + n - 2, sizeof(expected) - n + 2, ";91m");
+    check_golden(&lut, in, strlen(in), expected, strlen(expected));
+}
+
+
+/* remap_fd() through a pipe */
+static void test_fd(void) {
+    static const char in[] = "a\033[31mb\033[?31mc\033[38;5;196md";
+    static const char expected[] = "a\033[91mb\033[?31mc\033[38;5;160md";
+    char out[128];
+    int in_pipe[2], out_pipe[2];
+    t_remap_lut lut;
+
+    remap_lut_init(&lut);
+    lut.base[1] = to_index(REMAP_TO_16, 9);
+    lut.palette[196] = to_index(REMAP_TO_256, 160);
+
+    CHECK(pipe(in_pipe) == 0 && pipe(out_pipe) == 0);
+    CHECK(write(in_pipe[1], in, sizeof(in) - 1) == (ssize_t)sizeof(in) - 1);
+    close(in_pipe[1]);
+    CHECK(remap_fd(in_pipe[0], out_pipe[1], &lut));
+    close(out_pipe[1]);
+
+    ssize_t n = read(out_pipe[0], out, sizeof(out));
+    CHECK(n == (ssize_t)sizeof(expected) - 1 && memcmp(out, expected, sizeof(expected) - 1) == 0);
+    close(in_pipe[0]);
+    close(out_pipe[0]);
+}
+
+
+int main(void) {
+    test_16_to_rgb();
+    test_256_to_256();
+    test_rgb_to_nearest();
+    test_theme_swap();
+    test_underline();
+    test_pass_through();
+    test_overflow();
+    test_fd();
+    return TEST_END();
+}
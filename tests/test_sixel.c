@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_sixel.h"
+#include "test.h"
+
+
+static int fail_writer(void *ctx, const char *data, size_t len) {
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return 0;
+}
+
+
+/* width * height wraps around: rejected before any allocation or pixel access */
+static void test_overflow(void) {
+    t_rgb pixels[4] = {{255, 0, 0}, {0, 255, 0}, {0, 0, 255}, {255, 255, 255}};
+    uint8_t indices[4] = {0};
+    t_sixel_palette palette;
+    char buf[256];
+    size_t huge = SIZE_MAX / 2 + 1;
+
+    CHECK(sixel_quantize(pixels, 2, 2, 4, &palette));
+    CHECK(palette.size == 4);
+
+    CHECK(!sixel_quantize(pixels, huge, 2, 4, &palette));
+    CHECK(!sixel_map(pixels, huge, 4, &palette, SIXEL_DITHER_NONE, indices));
+    CHECK(!sixel_write_image(fail_writer, NULL, pixels, 2, huge, 4, SIXEL_DITHER_NONE));
+    CHECK(sixel_encode(buf, sizeof(buf), indices, huge, 2, &palette) == 0);
+    CHECK(sixel_size_max(huge, 2, &palette) == 0);
+    CHECK(sixel_size_max(SIZE_MAX / 64, SIZE_MAX / 64, &palette) == 0);
+    CHECK(sixel_size_max(2, 2, &palette) > 0);
+}
+
+
+static void test_encode(void) {
+    t_sixel_palette palette = {2, {{255, 0, 0}, {0, 0, 255}}};
+    uint8_t indices[2 * 7] = {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 1, 1};
+    char buf[256];
+
+    size_t len = sixel_encode(buf, sizeof(buf), indices, 2, 7, &palette);
+    CHECK(len == strlen(buf));
+    CHECK(len < sixel_size_max(2, 7, &palette));
+    CHECK(strcmp(buf, "\033P0;1;0q\"1;1;2;7#0;2;100;0;0#1;2;0;0;100#0~$#1?~-#1@@\033\\") == 0);
+}
+
+
+int main(void) {
+    test_overflow();
+    test_encode();
+    return TEST_END();
+}
@@ -0,0 +1,104 @@
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_stats.h"
+#include "test.h"
+
+
+static t_color_stats scan(const char *buf) {
+    t_color_stats s;
+
+    color_stats_reset();
+    color_stats_scan(buf, strlen(buf));
+    color_stats_snapshot(&s);
+    return s;
+}
+
+
+static uint64_t total_sequences(const t_color_stats *s) {
+    uint64_t n = 0;
+
+    for (int i = 0; i < NB_STATS_CATEGORIES; i++) n += s->sequences[i];
+    return n;
+}
+
+
+static void test_categories(void) {
+    t_color_stats s = scan("\033[31mA\033[48;5;21mB\033[38;2;1;2;3m\033[2J\033[?25l\033[0m");
+
+    CHECK(s.sequences[STATS_FORE] == 1 && s.sequence_bytes[STATS_FORE] == 5);
+    CHECK(s.sequences[STATS_COLOR8] == 1);
+    CHECK(s.sequences[STATS_COLOR24] == 1);
+    CHECK(s.sequences[STATS_SCREEN] == 1);
+    CHECK(s.sequences[STATS_CURSOR] == 1);
+    CHECK(s.sequences[STATS_STYLE] == 1);
+    CHECK(s.text_bytes == 2);
+}
+
+
+/* Each parameter group is classified, the sequence counts once under the highest ranked */
+static void test_sgr_groups(void) {
+    static const struct {
+        const char *seq;
+        StatsCategory category;
+    } cases[] = {
+        {"\033[1;31m", STATS_FORE},
+        {"\033[0;44m", STATS_BACK},
+        {"\033[31;44m", STATS_FORE},
+        {"\033[44;31m", STATS_BACK},
+        {"\033[0;38;2;1;2;3m", STATS_COLOR24},
+        {"\033[1;38;5;21;4m", STATS_COLOR8},
+        {"\033[38;5;21;48;2;1;2;3m", STATS_COLOR24},
+        {"\033[31;48;5;2m", STATS_COLOR8},
+        {"\033[38:2::1:2:3;31m", STATS_COLOR24},
+        {"\033[58:5:2m", STATS_COLOR8},
+        {"\033[38;2;1;2;31m", STATS_COLOR24},  /* 31 is the blue component, not a color */
+        {"\033[38;5;30m", STATS_COLOR8},
+        {"\033[38;31m", STATS_FORE},
+        {"\033[1;4;22m", STATS_STYLE},
+        {"\033[m", STATS_STYLE},
+        {"\033[;;m", STATS_STYLE}
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        t_color_stats s = scan(cases[i].seq);
+        if (total_sequences(&s) != 1 || s.sequences[cases[i].category] != 1
+            || s.sequence_bytes[cases[i].category] != strlen(cases[i].seq)) {
+            fprintf(stderr, "\\033%s\n", cases[i].seq + 1);
+            CHECK(0);
+        }
+    }
+}
+
+
+/* Only 0x40-0x7E ends a CSI */
+static void test_final_byte(void) {
+    /* A C0 control inside the sequence is executed, the sequence goes on */
+    t_color_stats s = scan("\033[3\n1mX");
+    CHECK(total_sequences(&s) == 1);
+    CHECK(s.sequence_bytes[STATS_STYLE] == 6);
+    CHECK(s.text_bytes == 1);
+
+    /* ESC cancels it and starts the next one */
+    s = scan("\033[12\033[32m");
+    CHECK(s.sequences[STATS_OTHER] == 1 && s.sequence_bytes[STATS_OTHER] == 4);
+    CHECK(s.sequences[STATS_FORE] == 1 && s.sequence_bytes[STATS_FORE] == 5);
+
+    /* So does CAN, which is not part of the sequence */
+    s = scan("\033[1\030x");
+    CHECK(s.sequences[STATS_OTHER] == 1 && s.sequence_bytes[STATS_OTHER] == 3);
+    CHECK(s.text_bytes == 2);
+
+    /* Unfinished at the end of the buffer */
+    s = scan("\033[38;5");
+    CHECK(s.sequences[STATS_OTHER] == 1 && s.sequence_bytes[STATS_OTHER] == 6);
+}
+
+
+int main(void) {
+    color_stats_enable(1);
+    test_categories();
+    test_sgr_groups();
+    test_final_byte();
+    return TEST_END();
+}
@@ -0,0 +1,127 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_term.h"
+#include "test.h"
+
+
+/* Fake terminal on the pty master: waits for 'query', then sends 'reply' */
+typedef struct s_responder {
+    int master;
+    const char *query;
+    const char *reply;
+    char received[128];
+    size_t received_len;
+} t_responder;
+
+
+static void *respond(void *arg) {
+    t_responder *r = arg;
+    size_t query_len = strlen(r->query);
+
+    while (r->received_len < query_len) {
+        struct pollfd pfd = {r->master, POLLIN, 0};
+        if (poll(&pfd, 1, 2000) <= 0) return NULL;
+
+        ssize_t n = read(r->master, r->received + r->received_len, sizeof(r->received) - r->received_len - 1);
+        if (n <= 0) return NULL;
+        r->received_len += (size_t)n;
+    }
+    r->received[r->received_len] = '\0';
+
+    if (strcmp(r->received, r->query) == 0) {
+        ssize_t n = write(r->master, r->reply, strlen(r->reply));
+        (void)n;
+    }
+    return NULL;
+}
+
+
+static int open_term(int *master, int *slave) {
+    return openpty(master, slave, NULL, NULL, NULL) == 0;
+}
+
+
+static void test_cursor_pos(void) {
+    int master, slave;
+    pthread_t thread;
+    t_cursor_pos pos = {0, 0};
+
+    if (!open_term(&master, &slave)) return;
+
+    /* Unrelated input (a DA reply) before the position is skipped */
+    t_responder r = {master, "\033[6n", "\033[?62;22c\033[12;34R", {0}, 0};
+    pthread_create(&thread, NULL, respond, &r);
+    CHECK(term_cursor_pos(slave, slave, &pos, 2000));
+    pthread_join(thread, NULL);
+
+    CHECK(strcmp(r.received, "\033[6n") == 0);
+    CHECK(pos.row == 12 && pos.col == 34);
+
+    close(master);
+    close(slave);
+}
+
+
+static void test_query_size(void) {
+    int master, slave;
+    pthread_t thread;
+    t_term_size size = {0, 0, 0, 0};
+
+    if (!open_term(&master, &slave)) return;
+
+    t_responder r = {master, "\0337\033[9999;9999H\033[6n\0338", "\033[50;132R", {0}, 0};
+    pthread_create(&thread, NULL, respond, &r);
+    CHECK(term_query_size(slave, slave, &size, 2000));
+    pthread_join(thread, NULL);
+
+    CHECK(strcmp(r.received, r.query) == 0);
+    CHECK(size.rows == 50 && size.cols == 132);
+
+    close(master);
+    close(slave);
+}
+
+
+static void test_timeout(void) {
+    int master, slave;
+    t_cursor_pos pos;
+    char query[16];
+
+    if (!open_term(&master, &slave)) return;
+
+    /* Nobody answers */
+    errno = 0;
+    CHECK(!term_cursor_pos(slave, slave, &pos, 50));
+    CHECK(errno == ETIMEDOUT);
+
+    /* The query was still sent */
+    ssize_t n = read(master, query, sizeof(query));
+    CHECK(n == 4 && memcmp(query, "\033[6n", 4) == 0);
+
+    /* A reply of another kind does not end the wait */
+    n = write(master, "\033[?1;2c", 7);
+    errno = 0;
+    CHECK(!term_cursor_pos(slave, slave, &pos, 50));
+    CHECK(errno == ETIMEDOUT);
+
+    close(master);
+    close(slave);
+}
+
+
+int main(void) {
+    /* Default tables only: the queries must not depend on the Cursor table */
+    init_color(NULL, 0, 1, 0, COLOR_FLAG_INIT_DEFAULT);
+
+    test_cursor_pos();
+    test_query_size();
+    test_timeout();
+    return TEST_END();
+}
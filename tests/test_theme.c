@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "color_lib.h"
+#include "color_theme.h"
+#include "test.h"
+
+
+static char g_dir[] = "/tmp/color_theme_XXXXXX";
+static char g_source[64];
+static char g_cache[64];
+
+
+static void write_text(const char *path, const char *text) {
+    FILE *f = fopen(path, "w");
+
+    CHECK(f != NULL);
+    if (!f) return;
+    fputs(text, f);
+    fclose(f);
+}
+
+
+static int get_is(const t_theme *theme, const char *name, const char *expected) {
+    size_t len = 0;
+    const char *seq = theme_get(theme, name, &len);
+
+    return seq && len == strlen(expected) && strcmp(seq, expected) == 0;
+}
+
+
+static uint64_t cache_inode(void) {
+    struct stat st;
+
+    return (stat(g_cache, &st) == 0) ? (uint64_t)st.st_ino : 0;
+}
+
+
+static void set_mtime(const char *path, time_t sec) {
+    struct timespec times[2] = {{sec, 0}, {sec, 0}};
+
+    CHECK(utimensat(AT_FDCWD, path, times, 0) == 0);
+}
+
+
+static void test_compile_load_get(void) {
+    write_text(g_source,
+        "; comment\n"
+        "error   = bold #ff5555\n"
+        "warning = yellow on #303030\n"
+        "link    = underline rgb(80, 160, 255)\n"
+        "plain   = reset\n");
+
+    t_theme *theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme != NULL);
+    if (!theme) return;
+
+    CHECK(theme->header->nb_entries == 4);
+    CHECK(get_is(theme, "error", "\033[1m\033[38;2;255;85;85m"));
+    CHECK(get_is(theme, "link", "\033[4m\033[38;2;80;160;255m"));
+    CHECK(get_is(theme, "plain", "\033[0m"));
+    CHECK(theme_get(theme, "warning", NULL) != NULL);
+    CHECK(theme_get(theme, "missing", NULL) == NULL);
+    CHECK(theme_get(theme, "erro", NULL) == NULL);
+    theme_close(theme);
+
+    /* Shipped cache only */
+    theme = theme_load(NULL, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && get_is(theme, "error", "\033[1m\033[38;2;255;85;85m"));
+    theme_close(theme);
+}
+
+
+/* Any flipped byte fails validation: no source means no theme, a source means a rebuild */
+static void test_corrupted(void) {
+    CHECK(theme_compile(g_source, g_cache, GRADIENT_DEPTH_24));
+
+    struct stat st;
+    CHECK(stat(g_cache, &st) == 0);
+    for (off_t at = 0; at < st.st_size; at += 7) {
+        int fd = open(g_cache, O_RDWR);
+        unsigned char c;
+        CHECK(pread(fd, &c, 1, at) == 1);
+        c ^= 0x40;
+        CHECK(pwrite(fd, &c, 1, at) == 1);
+        close(fd);
+
+        t_theme *theme = theme_load(NULL, g_cache, GRADIENT_DEPTH_24);
+        if (theme) {
+            /* Only the mtime, size and hash of the source are outside the checksum */
+            CHECK(at >= 16 && at < 40);
+            theme_close(theme);
+        }
+
+        theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+        CHECK(theme && get_is(theme, "plain", "\033[0m"));
+        theme_close(theme);
+    }
+
+    /* Truncated */
+    CHECK(truncate(g_cache, sizeof(t_theme_header) + 3) == 0);
+    CHECK(theme_load(NULL, g_cache, GRADIENT_DEPTH_24) == NULL);
+    t_theme *theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && get_is(theme, "plain", "\033[0m"));
+    theme_close(theme);
+}
+
+
+/* Touched with the same content: no rebuild, the new mtime is stored through a renamed copy */
+static void test_touched(void) {
+    set_mtime(g_source, 1000000000);
+    theme_close(theme_load(g_source, g_cache, GRADIENT_DEPTH_24));
+    t_theme *theme = theme_load(NULL, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && theme->header->source_mtime_ns == 1000000000ull * 1000000000ull);
+    uint64_t inode = cache_inode();
+
+    set_mtime(g_source, 1200000000);
+    t_theme *touched = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(touched && get_is(touched, "error", "\033[1m\033[38;2;255;85;85m"));
+    CHECK(cache_inode() != inode);
+
+    /* The mapping in use was left alone */
+    CHECK(theme && theme->header->source_mtime_ns == 1000000000ull * 1000000000ull);
+    theme_close(theme);
+    theme_close(touched);
+
+    theme = theme_load(NULL, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && theme->header->source_mtime_ns == 1200000000ull * 1000000000ull);
+    theme_close(theme);
+
+    /* Fresh by mtime: the cache is not rewritten */
+    inode = cache_inode();
+    theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && cache_inode() == inode);
+    theme_close(theme);
+}
+
+
+static void test_depth_mismatch(void) {
+    CHECK(theme_compile(g_source, g_cache, GRADIENT_DEPTH_24));
+    CHECK(theme_load(NULL, g_cache, GRADIENT_DEPTH_8) == NULL);
+
+    t_theme *theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_8);
+    CHECK(theme && get_is(theme, "error", "\033[1m\033[38;5;203m"));
+    theme_close(theme);
+
+    theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && get_is(theme, "error", "\033[1m\033[38;2;255;85;85m"));
+    theme_close(theme);
+}
+
+
+/* A source that stops compiling keeps the previous cache */
+static void test_broken_source(void) {
+    t_theme *theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme != NULL);
+    theme_close(theme);
+
+    write_text(g_source, "error = bold #ff5555\nwarning = not-a-color\n");
+    CHECK(!theme_compile(g_source, g_cache, GRADIENT_DEPTH_24));
+    theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && get_is(theme, "link", "\033[4m\033[38;2;80;160;255m"));
+    theme_close(theme);
+
+    write_text(g_source, "no equal sign\n");
+    unlink(g_cache);
+    CHECK(theme_load(g_source, g_cache, GRADIENT_DEPTH_24) == NULL);
+}
+
+
+static void test_empty(void) {
+    write_text(g_source, "");
+    t_theme *theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_24);
+    CHECK(theme && theme->header->nb_entries == 0);
+    CHECK(theme_get(theme, "error", NULL) == NULL);
+    theme_close(theme);
+
+    write_text(g_source, "; only comments\n\n   \n# and this\n");
+    theme = theme_load(g_source, g_cache, GRADIENT_DEPTH_8);
+    CHECK(theme && theme->header->nb_entries == 0);
+    theme_close(theme);
+}
+
+
+int main(void) {
+    if (!mkdtemp(g_dir)) return 1;
+    snprintf(g_source, sizeof(g_source), "%s/theme.txt", g_dir);
+    snprintf(g_cache, sizeof(g_cache), "%s/theme.bin", g_dir);
+
+    test_compile_load_get();
+    test_corrupted();
+    test_touched();
+    test_depth_mismatch();
+    test_broken_source();
+    test_empty();
+
+    unlink(g_source);
+    unlink(g_cache);
+    rmdir(g_dir);
+    return TEST_END();
+}
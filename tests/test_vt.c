@@ -0,0 +1,53 @@
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_vt.h"
+#include "test.h"
+
+
+/* 1-based, like vt_cell() */
+static uint32_t ch_at(const t_vt *vt, uint16_t row, uint16_t col) {
+    const t_vt_cell *cell = vt_cell(vt, row, col);
+    return (cell) ? cell->ch : 0xFFFFFFFF;
+}
+
+
+static void test_one_column(void) {
+    t_vt *vt = vt_new(2, 1);
+
+    /* U+4E2D is two columns wide */
+    vt_write(vt, "\xE4\xB8\xAD\xE4\xB8\xAD\xE4\xB8\xAD", 9);
+    CHECK(ch_at(vt, 1, 1) == 0xFFFD);
+    CHECK(ch_at(vt, 2, 1) == 0xFFFD);
+    vt_free(vt);
+}
+
+
+static void test_overwrite_halves(void) {
+    t_vt *vt = vt_new(1, 6);
+
+    /* Right half overwritten: the left half is blanked */
+    vt_write(vt, "\xE4\xB8\xAD\033[1;2Hx", 3 + 6 + 1);
+    CHECK(ch_at(vt, 1, 1) == ' ');
+    CHECK(ch_at(vt, 1, 2) == 'x');
+
+    /* Left half overwritten: the right half is blanked */
+    vt_write(vt, "\033[1;4H\xE4\xB8\xAD\033[1;4Hy", 6 + 3 + 6 + 1);
+    CHECK(ch_at(vt, 1, 4) == 'y');
+    CHECK(ch_at(vt, 1, 5) == ' ');
+
+    /* Wide glyph straddling two wide glyphs: both outer halves are blanked */
+    vt_write(vt, "\033[1;1H\xE4\xB8\xAD\xE4\xB8\xAD\033[1;2H\xE4\xB8\xAD", 6 + 6 + 6 + 3);
+    CHECK(ch_at(vt, 1, 1) == ' ');
+    CHECK(ch_at(vt, 1, 2) == 0x4E2D);
+    CHECK(ch_at(vt, 1, 3) == 0);
+    CHECK(ch_at(vt, 1, 4) == ' ');
+    vt_free(vt);
+}
+
+
+int main(void) {
+    test_one_column();
+    test_overwrite_halves();
+    return TEST_END();
+}
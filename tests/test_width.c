@@ -0,0 +1,155 @@
+/* Built twice by make test: with the SSE2 ASCII scanner and with the SWAR one (test_width_swar) */
+#include <stdlib.h>
+#include <string.h>
+
+#include "color_lib.h"
+#include "color_width.h"
+#include "test.h"
+
+
+static int padded(const char *s, size_t width, TextAlign align, const char *expected) {
+    char dst[128];
+    size_t len = str_pad(dst, sizeof(dst), s, width, align);
+
+    return len == strlen(expected) && strcmp(dst, expected) == 0;
+}
+
+
+static int truncated(const char *s, size_t width, const char *ellipsis, const char *expected) {
+    char dst[128];
+    size_t len = str_truncate(dst, sizeof(dst), s, width, ellipsis);
+
+    return len == strlen(expected) && strcmp(dst, expected) == 0;
+}
+
+
+static int fitted(const char *s, size_t width, TextAlign align, const char *expected) {
+    const char *str = str_fit(s, width, align);
+
+    return str && strcmp(str, expected) == 0;
+}
+
+
+static void test_escapes(void) {
+    CHECK(str_width("\033[31mred\033[0m") == 3);
+    CHECK(str_width("\033[38;2;255;128;0m\033[1;4mab") == 2);
+    CHECK(str_width("a\033]0;title\007b") == 2);
+    CHECK(str_width("\033]8;;http://x.org\033\\link\033]8;;\033\\") == 4);
+    CHECK(str_width("\0337x\0338") == 1);
+    CHECK(str_width("\033Pq#0~-\033\\z") == 1);
+
+    /* Unfinished sequences take the rest of the string */
+    CHECK(str_width("ab\033[31") == 2);
+    CHECK(str_width("ab\033]0;no end") == 2);
+    CHECK(str_width_n("\033[31mab", 3) == 0);
+}
+
+
+static void test_glyphs(void) {
+    CHECK(str_width("") == 0);
+    CHECK(str_width(NULL) == 0);
+    CHECK(str_width("\xE4\xB8\xAD\xE6\x96\x87") == 4);   /* 中文 */
+    CHECK(str_width("\xF0\x9F\x98\x80") == 2);           /* U+1F600 */
+    CHECK(str_width("e\xCC\x81") == 1);                  /* e + combining acute */
+    CHECK(str_width("\xC3\xA9t\xC3\xA9") == 3);          /* été */
+    CHECK(str_width("a\tb\x7F") == 2);                   /* Controls take no column */
+    CHECK(codepoint_width(0x200B) == 0);
+    CHECK(codepoint_width(0xFF21) == 2);
+    CHECK(codepoint_width(0x00E9) == 1);
+}
+
+
+/* Invalid bytes count as one column each */
+static void test_invalid_utf8(void) {
+    CHECK(str_width("\xFF\xFE") == 2);
+    CHECK(str_width("\xC0\xAF") == 2);        /* Overlong */
+    CHECK(str_width("\x80" "a") == 2);        /* Lone continuation */
+    CHECK(str_width("\xE4\xB8") == 2);        /* Cut at the end */
+    CHECK(str_width("\xE4\xB8" "a") == 3);    /* Cut before ASCII */
+    CHECK(str_width("\xF5\x80\x80\x80") == 4);
+}
+
+
+/* Every run length and every position of a non-printable byte, across the 16 and 8-byte blocks */
+static void test_ascii_runs(void) {
+    static const unsigned char BREAKS[] = {0x00, 0x1F, 0x7F, 0x80, 0xFF};
+    static const int BREAK_WIDTH[] = {0, 0, 0, 1, 1};
+    char s[80];
+
+    for (size_t len = 0; len < sizeof(s); len++) {
+        for (size_t i = 0; i < len; i++) s[i] = (i & 1) ? 0x20 : 0x7E;
+        CHECK(str_width_n(s, len) == len);
+
+        for (size_t k = 0; k < len; k++) {
+            for (size_t b = 0; b < sizeof(BREAKS); b++) {
+                s[k] = (char)BREAKS[b];
+                if (str_width_n(s, len) != len - 1 + BREAK_WIDTH[b]) {
+                    fprintf(stderr, "len %zu, byte 0x%02X at %zu\n", len, BREAKS[b], k);
+                    CHECK(0);
+                }
+            }
+            s[k] = 'x';
+        }
+    }
+}
+
+
+static void test_pad(void) {
+    CHECK(padded("ab", 0, ALIGN_LEFT, "ab"));
+    CHECK(padded("ab", 1, ALIGN_RIGHT, "ab"));
+    CHECK(padded("ab", 5, ALIGN_LEFT, "ab   "));
+    CHECK(padded("ab", 5, ALIGN_RIGHT, "   ab"));
+    CHECK(padded("\033[1mab\033[0m", 6, ALIGN_CENTER, "  \033[1mab\033[0m  "));
+    CHECK(padded("\xE4\xB8\xAD", 3, ALIGN_LEFT, "\xE4\xB8\xAD "));
+    CHECK(padded("", 1, ALIGN_LEFT, " "));
+
+    char small[4];
+    CHECK(str_pad(small, sizeof(small), "ab", 4, ALIGN_LEFT) == 0);
+}
+
+
+static void test_truncate(void) {
+    CHECK(truncated("abcdef", 0, "\xE2\x80\xA6", ""));
+    CHECK(truncated("abcdef", 1, "\xE2\x80\xA6", "\xE2\x80\xA6"));
+    CHECK(truncated("abcdef", 3, "\xE2\x80\xA6", "ab\xE2\x80\xA6"));
+    CHECK(truncated("abcdef", 3, NULL, "abc"));
+    CHECK(truncated("abc", 3, "\xE2\x80\xA6", "abc"));
+
+    /* Escapes after the cut are kept */
+    CHECK(truncated("\033[31mabcdef\033[0m", 3, "\xE2\x80\xA6", "\033[31mab\xE2\x80\xA6\033[0m"));
+
+    /* A wide glyph across the cut is dropped whole */
+    CHECK(truncated("a\xE4\xB8\xAD" "b", 2, "\xE2\x80\xA6", "a\xE2\x80\xA6"));
+    CHECK(truncated("a\xE4\xB8\xAD" "b", 2, NULL, "a"));
+    CHECK(truncated("a\xE4\xB8\xAD" "b", 3, NULL, "a\xE4\xB8\xAD"));
+
+    /* Combining marks stay with their base */
+    CHECK(truncated("e\xCC\x81" "fg", 2, NULL, "e\xCC\x81" "f"));
+}
+
+
+static void test_fit(void) {
+    CHECK(fitted("ab", 0, ALIGN_LEFT, ""));
+    CHECK(fitted("ab", 1, ALIGN_LEFT, "\xE2\x80\xA6"));
+    CHECK(fitted("a", 1, ALIGN_LEFT, "a"));
+    CHECK(fitted("abcdef", 4, ALIGN_LEFT, "abc\xE2\x80\xA6"));
+    CHECK(fitted("a", 3, ALIGN_RIGHT, "  a"));
+    CHECK(fitted("a", 4, ALIGN_CENTER, " a  "));
+
+    /* 中文字: the cut falls inside 文, padded back to the width */
+    CHECK(fitted("\xE4\xB8\xAD\xE6\x96\x87\xE5\xAD\x97", 5, ALIGN_LEFT, "\xE4\xB8\xAD\xE6\x96\x87\xE2\x80\xA6"));
+    CHECK(fitted("\xE4\xB8\xAD\xE6\x96\x87\xE5\xAD\x97", 4, ALIGN_LEFT, "\xE4\xB8\xAD\xE2\x80\xA6 "));
+    CHECK(str_width(str_fit("\033[32m\xE4\xB8\xAD\xE6\x96\x87\033[0m", 3, ALIGN_RIGHT)) == 3);
+}
+
+
+int main(void) {
+    test_escapes();
+    test_glyphs();
+    test_invalid_utf8();
+    test_ascii_runs();
+    test_pad();
+    test_truncate();
+    test_fit();
+    return TEST_END();
+}